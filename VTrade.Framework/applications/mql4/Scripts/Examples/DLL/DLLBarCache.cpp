@@ -0,0 +1,314 @@
+//+------------------------------------------------------------------+
+//|                              Memory-mapped columnar bar cache   |
+//|                             Copyright 2000-2024, MetaQuotes Ltd. |
+//|                                               www.metaquotes.net |
+//+------------------------------------------------------------------+
+//| Maps a bar cache file (see BarCacheHeader in DLLSample.h) read-  |
+//| only and hands out column pointers into the mapping. Opening a   |
+//| cache costs one header check, not a read of the whole file: the  |
+//| OS pages the columns in as kernels touch them, and repeated runs |
+//| are served from the file cache.                                  |
+//|                                                                  |
+//| MQL code gets a handle (1..BARCACHE_MAX_OPEN) and copies ranges  |
+//| out with BarCacheCopyRates/BarCacheColumn. Native kernels call   |
+//| BarCacheGetView and scan the mapped columns directly.            |
+//|                                                                  |
+//| Exports return the number of bars produced, 0 for an empty range |
+//| and -1 on wrong arguments or an invalid handle.                  |
+//+------------------------------------------------------------------+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "DLLSample.h"
+//---
+#define BARCACHE_MAX_OPEN 64
+//+------------------------------------------------------------------+
+//| Open mapping slot                                                |
+//+------------------------------------------------------------------+
+struct BarCacheSlot
+  {
+   HANDLE            file;
+   HANDLE            mapping;
+   const void       *base;
+   BarCacheView      view;
+  };
+//--- handle N lives in ExtSlots[N-1]; a NULL base marks a free slot
+static BarCacheSlot ExtSlots[BARCACHE_MAX_OPEN];
+static SRWLOCK      ExtSlotsLock=SRWLOCK_INIT;
+//+------------------------------------------------------------------+
+//| Header validation against the actual file size                   |
+//+------------------------------------------------------------------+
+static bool BarCacheValidate(const BarCacheHeader *header,const __int64 file_size)
+  {
+   if(file_size<(__int64)sizeof(BarCacheHeader))
+      return(false);
+   if(header->magic!=BARCACHE_MAGIC || header->version!=BARCACHE_VERSION)
+      return(false);
+   if(header->header_size<(int)sizeof(BarCacheHeader) || header->header_size%8!=0)
+      return(false);
+   if(header->bar_count<0 || header->bar_count>INT_MAX)
+      return(false);
+   return(file_size>=header->header_size+header->bar_count*8*BARCACHE_COLUMNS);
+  }
+//---
+static void BarCacheRelease(BarCacheSlot &slot)
+  {
+   if(slot.base!=NULL)
+      UnmapViewOfFile(slot.base);
+   if(slot.mapping!=NULL)
+      CloseHandle(slot.mapping);
+   if(slot.file!=INVALID_HANDLE_VALUE && slot.file!=NULL)
+      CloseHandle(slot.file);
+   memset(&slot,0,sizeof(slot));
+  }
+//+------------------------------------------------------------------+
+//| Column pointers for native kernels. The view stays valid until   |
+//| BarCacheClose for the same handle.                               |
+//+------------------------------------------------------------------+
+bool BarCacheGetView(const int handle,BarCacheView &view)
+  {
+   bool found=false;
+//---
+   AcquireSRWLockShared(&ExtSlotsLock);
+   if(handle>=1 && handle<=BARCACHE_MAX_OPEN && ExtSlots[handle-1].base!=NULL)
+     {
+      view=ExtSlots[handle-1].view;
+      found=true;
+     }
+   ReleaseSRWLockShared(&ExtSlotsLock);
+//---
+   return(found);
+  }
+//+------------------------------------------------------------------+
+//| Maps a cache file read-only. 'path' is a full path, e.g. built   |
+//| from TERMINAL_COMMONDATA_PATH. Returns a handle or -1.           |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall BarCacheOpen(const wchar_t *path)
+  {
+//---
+   if(path==NULL || path[0]==L'\0')
+     {
+      printf("BarCacheOpen: empty path\n");
+      return(-1);
+     }
+//---
+   BarCacheSlot slot;
+   memset(&slot,0,sizeof(slot));
+   slot.file=CreateFileW(path,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+   if(slot.file==INVALID_HANDLE_VALUE)
+     {
+      printf("BarCacheOpen: cannot open file (error %u)\n",(unsigned)GetLastError());
+      return(-1);
+     }
+   LARGE_INTEGER size;
+   if(!GetFileSizeEx(slot.file,&size) || size.QuadPart<(LONGLONG)sizeof(BarCacheHeader))
+     {
+      printf("BarCacheOpen: file too small\n");
+      BarCacheRelease(slot);
+      return(-1);
+     }
+   slot.mapping=CreateFileMappingW(slot.file,NULL,PAGE_READONLY,0,0,NULL);
+   if(slot.mapping!=NULL)
+      slot.base=MapViewOfFile(slot.mapping,FILE_MAP_READ,0,0,0);
+   if(slot.base==NULL)
+     {
+      printf("BarCacheOpen: cannot map file (error %u)\n",(unsigned)GetLastError());
+      BarCacheRelease(slot);
+      return(-1);
+     }
+//--- columns follow the header back to back
+   const BarCacheHeader *header=(const BarCacheHeader *)slot.base;
+   if(!BarCacheValidate(header,size.QuadPart))
+     {
+      printf("BarCacheOpen: invalid or truncated cache file\n");
+      BarCacheRelease(slot);
+      return(-1);
+     }
+   const int count=int(header->bar_count);
+   const char *columns=(const char *)slot.base+header->header_size;
+   slot.view.header=header;
+   slot.view.count =count;
+   slot.view.time  =(const __int64 *)columns;
+   slot.view.open  =(const double *)(slot.view.time+count);
+   slot.view.high  =slot.view.open+count;
+   slot.view.low   =slot.view.high+count;
+   slot.view.close =slot.view.low+count;
+   slot.view.volume=(const __int64 *)(slot.view.close+count);
+//---
+   int handle=-1;
+   AcquireSRWLockExclusive(&ExtSlotsLock);
+   for(int i=0; i<BARCACHE_MAX_OPEN; i++)
+     {
+      if(ExtSlots[i].base==NULL)
+        {
+         ExtSlots[i]=slot;
+         handle=i+1;
+         break;
+        }
+     }
+   ReleaseSRWLockExclusive(&ExtSlotsLock);
+//---
+   if(handle<0)
+     {
+      printf("BarCacheOpen: too many open caches (%d)\n",BARCACHE_MAX_OPEN);
+      BarCacheRelease(slot);
+     }
+   return(handle);
+  }
+//+------------------------------------------------------------------+
+//| Unmaps a cache. Returns 1, or -1 for an unknown handle.          |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall BarCacheClose(const int handle)
+  {
+   int result=-1;
+//---
+   AcquireSRWLockExclusive(&ExtSlotsLock);
+   if(handle>=1 && handle<=BARCACHE_MAX_OPEN && ExtSlots[handle-1].base!=NULL)
+     {
+      BarCacheRelease(ExtSlots[handle-1]);
+      result=1;
+     }
+   ReleaseSRWLockExclusive(&ExtSlotsLock);
+//---
+   return(result);
+  }
+//+------------------------------------------------------------------+
+//| Header summary: info[0]=bars, [1]=timeframe, [2]=first time,     |
+//| [3]=last time, [4]=created. Returns the bar count.               |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall BarCacheInfo(const int handle,__int64 *info,const int info_size)
+  {
+   BarCacheView view;
+//---
+   if(!BarCacheGetView(handle,view))
+     {
+      printf("BarCacheInfo: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   if(info!=NULL)
+     {
+      const __int64 values[5]={ view.count,view.header->timeframe,view.header->first_time,
+                                view.header->last_time,view.header->created };
+      for(int i=0; i<info_size && i<5; i++)
+         info[i]=values[i];
+     }
+//---
+   return(view.count);
+  }
+//+------------------------------------------------------------------+
+//| Index of the first bar with time >= 'time' (bar count if none).  |
+//| Binary search over the time column, which is ascending.          |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall BarCacheFind(const int handle,const __int64 time)
+  {
+   BarCacheView view;
+//---
+   if(!BarCacheGetView(handle,view))
+     {
+      printf("BarCacheFind: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   int lo=0,hi=view.count;
+   while(lo<hi)
+     {
+      int mid=lo+(hi-lo)/2;
+      if(view.time[mid]<time)
+         lo=mid+1;
+      else
+         hi=mid;
+     }
+//---
+   return(lo);
+  }
+//+------------------------------------------------------------------+
+//| Rebuilds MqlRates/RateInfo for bars [start, start+count) in      |
+//| ascending order (rates[0] = bar 'start'). Spread and real volume |
+//| are not cached and come back as 0.                               |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall BarCacheCopyRates(const int handle,const int start,const int count,
+                                            RateInfo *rates,const int rates_size)
+  {
+   BarCacheView view;
+//---
+   if(!BarCacheGetView(handle,view))
+     {
+      printf("BarCacheCopyRates: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   if(rates==NULL || rates_size<=0 || start<0 || count<0)
+     {
+      printf("BarCacheCopyRates: wrong arguments (start %d, count %d, size %d)\n",start,count,rates_size);
+      return(-1);
+     }
+   if(start>=view.count)
+      return(0);
+//---
+   int total=view.count-start;
+   if(total>count)
+      total=count;
+   if(total>rates_size)
+      total=rates_size;
+   for(int i=0; i<total; i++)
+     {
+      const int bar=start+i;
+      rates[i].ctm     =view.time[bar];
+      rates[i].open    =view.open[bar];
+      rates[i].high    =view.high[bar];
+      rates[i].low     =view.low[bar];
+      rates[i].close   =view.close[bar];
+      rates[i].vol_tick=view.volume[bar];
+      rates[i].spread  =0;
+      rates[i].vol_real=0;
+     }
+//---
+   return(total);
+  }
+//+------------------------------------------------------------------+
+//| Copies one column (RATE_TIME..RATE_VOLUME) for bars              |
+//| [start, start+count) into 'buffer', ascending order.             |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall BarCacheColumn(const int handle,const int nrate,const int start,const int count,
+                                         double *buffer,const int buffer_size)
+  {
+   BarCacheView view;
+//---
+   if(!BarCacheGetView(handle,view))
+     {
+      printf("BarCacheColumn: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   if(buffer==NULL || buffer_size<=0 || start<0 || count<0 || nrate<RATE_TIME || nrate>RATE_VOLUME)
+     {
+      printf("BarCacheColumn: wrong arguments (field %d, start %d, count %d)\n",nrate,start,count);
+      return(-1);
+     }
+   if(start>=view.count)
+      return(0);
+//---
+   int total=view.count-start;
+   if(total>count)
+      total=count;
+   if(total>buffer_size)
+      total=buffer_size;
+   const double *src=NULL;
+   switch(nrate)
+     {
+      case RATE_OPEN:  src=view.open;  break;
+      case RATE_HIGH:  src=view.high;  break;
+      case RATE_LOW:   src=view.low;   break;
+      case RATE_CLOSE: src=view.close; break;
+     }
+   if(src!=NULL)
+      memcpy(buffer,src+start,sizeof(double)*size_t(total));
+   else
+     {
+      const __int64 *isrc=(nrate==RATE_TIME ? view.time : view.volume)+start;
+      for(int i=0; i<total; i++)
+         buffer[i]=double(isrc[i]);
+     }
+//---
+   return(total);
+  }
+//+------------------------------------------------------------------+
@@ -0,0 +1,494 @@
+//+------------------------------------------------------------------+
+//|                                  Native indicator engine for MQL |
+//|                             Copyright 2000-2024, MetaQuotes Ltd. |
+//|                                               www.metaquotes.net |
+//+------------------------------------------------------------------+
+//| Full-series EMA/RSI/ATR/MACD/Stochastic computed straight from   |
+//| the RateInfo array in one call. Formulas follow the terminal     |
+//| example indicators (MovingAverages.mqh, RSI, ATR, MACD,          |
+//| Stochastic) so the values match the built-in indicator handles.  |
+//|                                                                  |
+//| Output buffers are in rates order (buffer[i] belongs to rates[i],|
+//| oldest bar first) and must hold at least rates_total elements.   |
+//| Bars before the first computable value are set to 0.0 like the   |
+//| terminal does. Every export returns rates_total on success, 0 if |
+//| there are not enough bars and -1 on wrong arguments.             |
+//|                                                                  |
+//| Rates are first split into contiguous columns so every later     |
+//| pass is a unit-stride scan. Element-wise passes (applied price,  |
+//| true range, gains/losses, MACD difference) use AVX2 when the CPU |
+//| supports it. Recursive smoothing is sequential by nature and     |
+//| stays scalar. Every pass is O(n) in the number of bars except    |
+//| the Stochastic %K slowing sum, which is O(n*slowing) so a flat   |
+//| window stays exactly 0 instead of drifting with a running sum.   |
+//+------------------------------------------------------------------+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <intrin.h>
+#include <immintrin.h>
+#include "DLLSample.h"
+//--- doubles per AVX2 register
+#define AVX2_LANES 4
+//+------------------------------------------------------------------+
+//| CPU feature detection, evaluated once per process                |
+//+------------------------------------------------------------------+
+static int ExtAVX2=-1;
+//---
+static bool CpuHasAVX2(void)
+  {
+   if(ExtAVX2<0)
+     {
+      int info[4];
+      int avx2=0;
+      __cpuid(info,0);
+      if(info[0]>=7)
+        {
+         __cpuid(info,1);
+         //--- AVX and OSXSAVE present, and the OS saves YMM state
+         if((info[2]&(1<<27))!=0 && (info[2]&(1<<28))!=0 && (_xgetbv(0)&6)==6)
+           {
+            __cpuidex(info,7,0);
+            avx2=((info[1]&(1<<5))!=0);
+           }
+        }
+      ExtAVX2=avx2;
+     }
+   return(ExtAVX2!=0);
+  }
+//+------------------------------------------------------------------+
+//| Column copy of the rates plus scratch space, one allocation      |
+//+------------------------------------------------------------------+
+struct RateColumns
+  {
+   double           *open;
+   double           *high;
+   double           *low;
+   double           *close;
+   double           *work;      // 'work_columns' scratch columns of 'total' doubles
+   double           *memory;
+  };
+//---
+static bool ColumnsLoad(RateColumns &cols,const RateInfo *rates,const int total,const int work_columns)
+  {
+   cols.memory=(double *)malloc(sizeof(double)*size_t(total)*size_t(4+work_columns));
+   if(cols.memory==NULL)
+     {
+      printf("ColumnsLoad: cannot allocate %d bars\n",total);
+      return(false);
+     }
+   cols.open =cols.memory;
+   cols.high =cols.open+total;
+   cols.low  =cols.high+total;
+   cols.close=cols.low+total;
+   cols.work =cols.close+total;
+//--- single pass over the packed structures
+   for(int i=0; i<total; i++)
+     {
+      cols.open[i] =rates[i].open;
+      cols.high[i] =rates[i].high;
+      cols.low[i]  =rates[i].low;
+      cols.close[i]=rates[i].close;
+     }
+   return(true);
+  }
+//---
+static void ColumnsFree(RateColumns &cols)
+  {
+   free(cols.memory);
+   cols.memory=NULL;
+  }
+//+------------------------------------------------------------------+
+//| Element-wise kernels                                             |
+//+------------------------------------------------------------------+
+static const double *AppliedPrice(const RateColumns &cols,const int nrate,double *dst,const int total)
+  {
+   int i=0;
+   switch(nrate)
+     {
+      case RATE_OPEN:  return(cols.open);
+      case RATE_LOW:   return(cols.low);
+      case RATE_HIGH:  return(cols.high);
+      case RATE_CLOSE: return(cols.close);
+      case RATE_MEDIAN:
+         if(CpuHasAVX2())
+           {
+            const __m256d half=_mm256_set1_pd(0.5);
+            for(; i+AVX2_LANES<=total; i+=AVX2_LANES)
+               _mm256_storeu_pd(dst+i,_mm256_mul_pd(_mm256_add_pd(_mm256_loadu_pd(cols.high+i),_mm256_loadu_pd(cols.low+i)),half));
+           }
+         for(; i<total; i++)
+            dst[i]=(cols.high[i]+cols.low[i])*0.5;
+         break;
+      case RATE_TYPICAL:
+         if(CpuHasAVX2())
+           {
+            const __m256d three=_mm256_set1_pd(3.0);
+            for(; i+AVX2_LANES<=total; i+=AVX2_LANES)
+              {
+               __m256d sum=_mm256_add_pd(_mm256_loadu_pd(cols.high+i),_mm256_loadu_pd(cols.low+i));
+               sum=_mm256_add_pd(sum,_mm256_loadu_pd(cols.close+i));
+               _mm256_storeu_pd(dst+i,_mm256_div_pd(sum,three));
+              }
+           }
+         for(; i<total; i++)
+            dst[i]=(cols.high[i]+cols.low[i]+cols.close[i])/3.0;
+         break;
+      case RATE_WEIGHTED:
+         if(CpuHasAVX2())
+           {
+            const __m256d two=_mm256_set1_pd(2.0);
+            const __m256d quarter=_mm256_set1_pd(0.25);
+            for(; i+AVX2_LANES<=total; i+=AVX2_LANES)
+              {
+               __m256d sum=_mm256_add_pd(_mm256_loadu_pd(cols.high+i),_mm256_loadu_pd(cols.low+i));
+               sum=_mm256_add_pd(sum,_mm256_mul_pd(two,_mm256_loadu_pd(cols.close+i)));
+               _mm256_storeu_pd(dst+i,_mm256_mul_pd(sum,quarter));
+              }
+           }
+         for(; i<total; i++)
+            dst[i]=(cols.high[i]+cols.low[i]+2.0*cols.close[i])*0.25;
+         break;
+      default:
+         return(NULL);
+     }
+   return(dst);
+  }
+//---
+static void VecTrueRange(const RateColumns &cols,double *tr,const int total)
+  {
+   int i=1;
+//--- the first bar has no previous close
+   tr[0]=cols.high[0]-cols.low[0];
+   if(CpuHasAVX2())
+      for(; i+AVX2_LANES<=total; i+=AVX2_LANES)
+        {
+         __m256d prev=_mm256_loadu_pd(cols.close+i-1);
+         __m256d high=_mm256_max_pd(_mm256_loadu_pd(cols.high+i),prev);
+         __m256d low =_mm256_min_pd(_mm256_loadu_pd(cols.low+i),prev);
+         _mm256_storeu_pd(tr+i,_mm256_sub_pd(high,low));
+        }
+   for(; i<total; i++)
+     {
+      double prev=cols.close[i-1];
+      double high=(cols.high[i]>prev ? cols.high[i] : prev);
+      double low =(cols.low[i]<prev ? cols.low[i] : prev);
+      tr[i]=high-low;
+     }
+  }
+//---
+static void VecGainLoss(const double *price,double *gain,double *loss,const int total)
+  {
+   int i=1;
+   gain[0]=0.0;
+   loss[0]=0.0;
+   if(CpuHasAVX2())
+     {
+      const __m256d zero=_mm256_setzero_pd();
+      for(; i+AVX2_LANES<=total; i+=AVX2_LANES)
+        {
+         __m256d diff=_mm256_sub_pd(_mm256_loadu_pd(price+i),_mm256_loadu_pd(price+i-1));
+         _mm256_storeu_pd(gain+i,_mm256_max_pd(diff,zero));
+         _mm256_storeu_pd(loss+i,_mm256_max_pd(_mm256_sub_pd(zero,diff),zero));
+        }
+     }
+   for(; i<total; i++)
+     {
+      double diff=price[i]-price[i-1];
+      gain[i]=(diff>0.0 ? diff : 0.0);
+      loss[i]=(diff<0.0 ? -diff : 0.0);
+     }
+  }
+//---
+static void VecSub(const double *left,const double *right,double *dst,const int total)
+  {
+   int i=0;
+   if(CpuHasAVX2())
+      for(; i+AVX2_LANES<=total; i+=AVX2_LANES)
+         _mm256_storeu_pd(dst+i,_mm256_sub_pd(_mm256_loadu_pd(left+i),_mm256_loadu_pd(right+i)));
+   for(; i<total; i++)
+      dst[i]=left[i]-right[i];
+  }
+//+------------------------------------------------------------------+
+//| Smoothing passes, same recurrences as MovingAverages.mqh         |
+//+------------------------------------------------------------------+
+static void CalcEMA(const double *price,const int total,const int period,double *buffer)
+  {
+   double smooth=2.0/(1.0+period);
+//---
+   buffer[0]=price[0];
+   for(int i=1; i<total; i++)
+      buffer[i]=price[i]*smooth+buffer[i-1]*(1.0-smooth);
+  }
+//---
+static void CalcSMA(const double *price,const int total,const int begin,const int period,double *buffer)
+  {
+   int    start=begin+period;
+   double first=0.0;
+   int    i;
+//---
+   for(i=0; i<start-1; i++)
+      buffer[i]=0.0;
+   for(i=begin; i<start; i++)
+      first+=price[i];
+   buffer[start-1]=first/period;
+   for(i=start; i<total; i++)
+      buffer[i]=buffer[i-1]+(price[i]-price[i-period])/period;
+  }
+//+------------------------------------------------------------------+
+//| Argument checks shared by all indicator exports                  |
+//+------------------------------------------------------------------+
+static bool IndicatorArgs(const char *func,const RateInfo *rates,const int rates_total,const int buffer_size)
+  {
+   if(rates==NULL)
+     {
+      printf("%s: NULL array\n",func);
+      return(false);
+     }
+   if(rates_total<=0)
+     {
+      printf("%s: wrong rates_total number (%d)\n",func,rates_total);
+      return(false);
+     }
+   if(buffer_size<rates_total)
+     {
+      printf("%s: buffer size (%d) is less than rates_total (%d)\n",func,buffer_size,rates_total);
+      return(false);
+     }
+   return(true);
+  }
+//---
+static bool IndicatorPrice(const char *func,const int nrate)
+  {
+   if((nrate>=RATE_OPEN && nrate<=RATE_CLOSE) || nrate==RATE_MEDIAN || nrate==RATE_TYPICAL || nrate==RATE_WEIGHTED)
+      return(true);
+   printf("%s: wrong applied price (%d)\n",func,nrate);
+   return(false);
+  }
+//+------------------------------------------------------------------+
+//| Exponential moving average of the applied price                  |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall IndicatorEMA(const RateInfo *rates,const int rates_total,const int period,const int nrate,
+                                       double *buffer,const int buffer_size)
+  {
+   if(!IndicatorArgs("IndicatorEMA",rates,rates_total,buffer_size) || !IndicatorPrice("IndicatorEMA",nrate))
+      return(-1);
+   if(buffer==NULL || period<1)
+     {
+      printf("IndicatorEMA: NULL buffer or wrong period (%d)\n",period);
+      return(-1);
+     }
+   if(period>rates_total)
+      return(0);
+//---
+   RateColumns cols;
+   if(!ColumnsLoad(cols,rates,rates_total,1))
+      return(-1);
+   CalcEMA(AppliedPrice(cols,nrate,cols.work,rates_total),rates_total,period,buffer);
+   ColumnsFree(cols);
+//---
+   return(rates_total);
+  }
+//+------------------------------------------------------------------+
+//| Relative strength index with Wilder smoothing                    |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall IndicatorRSI(const RateInfo *rates,const int rates_total,const int period,const int nrate,
+                                       double *buffer,const int buffer_size)
+  {
+   if(!IndicatorArgs("IndicatorRSI",rates,rates_total,buffer_size) || !IndicatorPrice("IndicatorRSI",nrate))
+      return(-1);
+   if(buffer==NULL || period<1)
+     {
+      printf("IndicatorRSI: NULL buffer or wrong period (%d)\n",period);
+      return(-1);
+     }
+   if(rates_total<=period)
+      return(0);
+//---
+   RateColumns cols;
+   if(!ColumnsLoad(cols,rates,rates_total,3))
+      return(-1);
+   double *gain=cols.work+rates_total;
+   double *loss=gain+rates_total;
+   VecGainLoss(AppliedPrice(cols,nrate,cols.work,rates_total),gain,loss,rates_total);
+//--- first 'period' values are not calculated
+   double pos=0.0;
+   double neg=0.0;
+   int    i;
+   buffer[0]=0.0;
+   for(i=1; i<=period; i++)
+     {
+      buffer[i]=0.0;
+      pos+=gain[i];
+      neg+=loss[i];
+     }
+   pos/=period;
+   neg/=period;
+//--- main recurrence, the first visible value is at 'period'
+   for(i=period; i<rates_total; i++)
+     {
+      if(i>period)
+        {
+         pos=(pos*(period-1)+gain[i])/period;
+         neg=(neg*(period-1)+loss[i])/period;
+        }
+      if(neg!=0.0)
+         buffer[i]=100.0-100.0/(1.0+pos/neg);
+      else
+         buffer[i]=(pos!=0.0 ? 100.0 : 50.0);
+     }
+   ColumnsFree(cols);
+//---
+   return(rates_total);
+  }
+//+------------------------------------------------------------------+
+//| Average true range, simple average of true range like iATR       |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall IndicatorATR(const RateInfo *rates,const int rates_total,const int period,
+                                       double *buffer,const int buffer_size)
+  {
+   if(!IndicatorArgs("IndicatorATR",rates,rates_total,buffer_size))
+      return(-1);
+   if(buffer==NULL || period<1)
+     {
+      printf("IndicatorATR: NULL buffer or wrong period (%d)\n",period);
+      return(-1);
+     }
+   if(rates_total<=period)
+      return(0);
+//---
+   RateColumns cols;
+   if(!ColumnsLoad(cols,rates,rates_total,1))
+      return(-1);
+   VecTrueRange(cols,cols.work,rates_total);
+//--- the first true range has no previous close and is skipped
+   CalcSMA(cols.work,rates_total,1,period,buffer);
+   buffer[0]=0.0;
+   ColumnsFree(cols);
+//---
+   return(rates_total);
+  }
+//+------------------------------------------------------------------+
+//| MACD: fast EMA minus slow EMA, signal is SMA of the main line    |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall IndicatorMACD(const RateInfo *rates,const int rates_total,const int fast_period,
+                                        const int slow_period,const int signal_period,const int nrate,
+                                        double *main,double *signal,const int buffer_size)
+  {
+   if(!IndicatorArgs("IndicatorMACD",rates,rates_total,buffer_size) || !IndicatorPrice("IndicatorMACD",nrate))
+      return(-1);
+   if(main==NULL || signal==NULL)
+     {
+      printf("IndicatorMACD: NULL buffer\n");
+      return(-1);
+     }
+   if(fast_period<=1 || slow_period<=1 || signal_period<=1)
+     {
+      printf("IndicatorMACD: wrong periods (%d,%d,%d)\n",fast_period,slow_period,signal_period);
+      return(-1);
+     }
+   if(rates_total<signal_period || rates_total<slow_period || rates_total<fast_period)
+      return(0);
+//---
+   RateColumns cols;
+   if(!ColumnsLoad(cols,rates,rates_total,3))
+      return(-1);
+   double *fast=cols.work+rates_total;
+   double *slow=fast+rates_total;
+   const double *price=AppliedPrice(cols,nrate,cols.work,rates_total);
+   CalcEMA(price,rates_total,fast_period,fast);
+   CalcEMA(price,rates_total,slow_period,slow);
+   VecSub(fast,slow,main,rates_total);
+   CalcSMA(main,rates_total,0,signal_period,signal);
+   ColumnsFree(cols);
+//---
+   return(rates_total);
+  }
+//+------------------------------------------------------------------+
+//| Stochastic oscillator (low/high price field, SMA signal).        |
+//| Highest high and lowest low over 'k_period' are kept in          |
+//| monotonic deques, so the window length does not affect cost.     |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall IndicatorStochastic(const RateInfo *rates,const int rates_total,const int k_period,
+                                              const int d_period,const int slowing,
+                                              double *main,double *signal,const int buffer_size)
+  {
+   if(!IndicatorArgs("IndicatorStochastic",rates,rates_total,buffer_size))
+      return(-1);
+   if(main==NULL || signal==NULL)
+     {
+      printf("IndicatorStochastic: NULL buffer\n");
+      return(-1);
+     }
+   if(k_period<1 || d_period<1 || slowing<1)
+     {
+      printf("IndicatorStochastic: wrong periods (%d,%d,%d)\n",k_period,d_period,slowing);
+      return(-1);
+     }
+   if(rates_total<=k_period+d_period+slowing)
+      return(0);
+//---
+   RateColumns cols;
+   if(!ColumnsLoad(cols,rates,rates_total,2))
+      return(-1);
+   int *queue=(int *)malloc(sizeof(int)*size_t(rates_total)*2);
+   if(queue==NULL)
+     {
+      printf("IndicatorStochastic: cannot allocate %d bars\n",rates_total);
+      ColumnsFree(cols);
+      return(-1);
+     }
+   double *lowest =cols.work;
+   double *highest=cols.work+rates_total;
+   int    *min_queue=queue;
+   int    *max_queue=queue+rates_total;
+   int     min_head=0,min_tail=0,max_head=0,max_tail=0;
+   int     i,k;
+//--- lowest low and highest high over k_period bars
+   for(i=0; i<rates_total; i++)
+     {
+      while(min_tail>min_head && cols.low[min_queue[min_tail-1]]>=cols.low[i])
+         min_tail--;
+      min_queue[min_tail++]=i;
+      while(max_tail>max_head && cols.high[max_queue[max_tail-1]]<=cols.high[i])
+         max_tail--;
+      max_queue[max_tail++]=i;
+      if(min_queue[min_head]<=i-k_period)
+         min_head++;
+      if(max_queue[max_head]<=i-k_period)
+         max_head++;
+      if(i<k_period-1)
+        {
+         lowest[i] =0.0;
+         highest[i]=0.0;
+        }
+      else
+        {
+         lowest[i] =cols.low[min_queue[min_head]];
+         highest[i]=cols.high[max_queue[max_head]];
+        }
+     }
+//--- %K with slowing, summed directly so a flat window stays exactly 0
+   int start=k_period-1+slowing-1;
+   for(i=0; i<start; i++)
+      main[i]=0.0;
+   for(i=start; i<rates_total; i++)
+     {
+      double sum_low=0.0;
+      double sum_high=0.0;
+      for(k=i-slowing+1; k<=i; k++)
+        {
+         sum_low +=cols.close[k]-lowest[k];
+         sum_high+=highest[k]-lowest[k];
+        }
+      main[i]=(sum_high==0.0 ? 100.0 : sum_low/sum_high*100.0);
+     }
+//--- %D averages only calculated %K values, the warm-up zeros are skipped
+   CalcSMA(main,rates_total,start,d_period,signal);
+   free(queue);
+   ColumnsFree(cols);
+//---
+   return(rates_total);
+  }
+//+------------------------------------------------------------------+
@@ -0,0 +1,520 @@
+//+------------------------------------------------------------------+
+//|                                 Parallel grid-search optimizer  |
+//|                             Copyright 2000-2024, MetaQuotes Ltd. |
+//|                                               www.metaquotes.net |
+//+------------------------------------------------------------------+
+//| Runs the OptimizeParameters.mq5 bar simulation for every         |
+//| parameter combination of a grid on all cores, then ranks the     |
+//| valid results by the selected score.                             |
+//|                                                                  |
+//| The simulation is a line-by-line port of RunOptimizationBacktest |
+//| (RSI entries, ATR stops, ATR regime risk), so for the same bars  |
+//| and symbol settings results equal the MQL ones.                  |
+//|                                                                  |
+//| Indicators do not depend on the swept parameters. RSI, ATR and   |
+//| the regime ATR average are computed once per call in O(n), with  |
+//| the same operation order as CGrandeIndicatorSeriesCache, and all |
+//| workers read the same arrays.                                    |
+//|                                                                  |
+//| Combinations are independent. Each worker owns a contiguous      |
+//| slice of the grid and takes from its front; an idle worker       |
+//| steals the back half of the largest remaining slice, so uneven   |
+//| combinations (pruned early, or with many trades) do not leave    |
+//| cores waiting at the end of a sweep.                             |
+//+------------------------------------------------------------------+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "DLLSample.h"
+//---
+#define OPT_MAX_THREADS 64       // WaitForMultipleObjects limit
+//+------------------------------------------------------------------+
+//| Price columns and precomputed indicators the kernel scans        |
+//+------------------------------------------------------------------+
+struct OptimizerBars
+  {
+   const double     *high;
+   const double     *low;
+   const double     *close;
+   const double     *rsi;
+   const double     *atr;
+   const double     *avg_atr;
+   int               total;
+  };
+//+------------------------------------------------------------------+
+//| Wilder RSI of the close. Warm-up bars hold a neutral 50 so they  |
+//| never look oversold or overbought.                               |
+//+------------------------------------------------------------------+
+static void OptimizerRSI(const double *close,const int total,const int period,double *rsi)
+  {
+   double pos=0.0,neg=0.0;
+//---
+   for(int i=0; i<total; i++)
+     {
+      rsi[i]=50.0;
+      if(i==0)
+         continue;
+      double diff=close[i]-close[i-1];
+      double gain=(diff>0.0 ? diff : 0.0);
+      double loss=(diff<0.0 ? -diff : 0.0);
+      if(i<=period)
+        {
+         pos+=gain;
+         neg+=loss;
+         if(i<period)
+            continue;
+         pos/=period;
+         neg/=period;
+        }
+      else
+        {
+         pos=(pos*(period-1)+gain)/period;
+         neg=(neg*(period-1)+loss)/period;
+        }
+      if(neg!=0.0)
+         rsi[i]=100.0-100.0/(1.0+pos/neg);
+      else
+         rsi[i]=(pos!=0.0 ? 100.0 : 50.0);
+     }
+  }
+//+------------------------------------------------------------------+
+//| ATR as the running average of true range (iATR), and the mean    |
+//| ATR of the 'window' bars before each bar for the regime check    |
+//+------------------------------------------------------------------+
+static void OptimizerATR(const OptimizerBars &bars,const int period,const int window,double *tr,double *atr,double *avg_atr)
+  {
+   double sum=0.0;
+//--- the first bar has no previous close and contributes no range
+   atr[0]=0.0;
+   for(int i=1; i<bars.total; i++)
+     {
+      double prev=bars.close[i-1];
+      tr[i]=(bars.high[i]>prev ? bars.high[i] : prev)-(bars.low[i]<prev ? bars.low[i] : prev);
+      if(i>period)
+         sum-=tr[i-period];
+      sum+=tr[i];
+      atr[i]=(i>=period ? sum/period : 0.0);
+     }
+//---
+   sum=0.0;
+   for(int i=0; i<bars.total; i++)
+     {
+      avg_atr[i]=(i>0 ? sum/(window<i ? window : i) : 0.0);
+      sum+=atr[i];
+      if(i>=window)
+         sum-=atr[i-window];
+     }
+  }
+//---
+static double OptimizerLotSize(const OptimizerSettings &set,const double balance,const double risk_percent,const double sl_pips)
+  {
+   double risk_amount=balance*(risk_percent/100.0);
+//---
+   if(set.tick_size==0 || set.pip_value==0)
+      return(0.01);
+   double value_per_pip=(set.tick_value/set.tick_size)*set.pip_value;
+   if(value_per_pip==0)
+      return(set.min_lot);
+//---
+   double lot=risk_amount/(sl_pips*value_per_pip);
+   lot=floor(lot/set.lot_step)*set.lot_step;
+   if(lot<set.min_lot)
+      lot=set.min_lot;
+   if(lot>set.max_lot)
+      lot=set.max_lot;
+   return(lot);
+  }
+//+------------------------------------------------------------------+
+//| One combination. Port of RunOptimizationBacktest.                |
+//+------------------------------------------------------------------+
+static void OptimizerRun(const OptimizerBars &bars,const OptimizerSettings &set,
+                         const OptimizerCombo &combo,OptimizerResult &res)
+  {
+   memset(&res,0,sizeof(res));
+   res.peak_balance =set.starting_balance;
+   res.final_balance=set.starting_balance;
+   if(bars.total<set.first_bar || set.pip_value==0)
+      return;
+//--- pruning is checked once, at this bar
+   int checkpoint=-1;
+   if(set.prune_checkpoint>0 && set.prune_checkpoint<1)
+      checkpoint=set.first_bar+int((bars.total-set.first_bar)*set.prune_checkpoint);
+//---
+   bool   in_position=false,is_buy=false;
+   double entry=0,stop_loss=0,take_profit=0,lot_size=0;
+   for(int i=set.first_bar; i<bars.total; i++)
+     {
+      double price=bars.close[i];
+      double atr=bars.atr[i];
+      double rsi=bars.rsi[i];
+      //--- regime from current ATR against its recent average
+      double risk=combo.risk_range;
+      bool   trend=false,breakout=false;
+      if(atr>0)
+        {
+         if(atr>bars.avg_atr[i]*2.0)
+            breakout=true;
+         else if(atr>bars.avg_atr[i]*1.2)
+            trend=true;
+        }
+      //--- exits
+      if(in_position)
+        {
+         bool   should_exit=false;
+         double exit_price=price;
+         if(is_buy)
+           {
+            if(bars.low[i]<=stop_loss)        { should_exit=true; exit_price=stop_loss;   }
+            else if(bars.high[i]>=take_profit) { should_exit=true; exit_price=take_profit; }
+           }
+         else
+           {
+            if(bars.high[i]>=stop_loss)       { should_exit=true; exit_price=stop_loss;   }
+            else if(bars.low[i]<=take_profit)  { should_exit=true; exit_price=take_profit; }
+           }
+         if(should_exit)
+           {
+            double diff=is_buy ? (exit_price-entry) : (entry-exit_price);
+            double pnl=(set.tick_size>0) ? (set.tick_value/set.tick_size)*diff*lot_size
+                                         : (diff/set.pip_value)*lot_size*10;
+            res.total_trades++;
+            res.final_balance+=pnl;
+            if(pnl>0)
+              {
+               res.winning_trades++;
+               res.gross_profit+=pnl;
+              }
+            else
+               res.gross_loss+=fabs(pnl);
+            if(res.final_balance>res.peak_balance)
+               res.peak_balance=res.final_balance;
+            double drawdown=res.peak_balance-res.final_balance;
+            if(drawdown>res.max_drawdown)
+               res.max_drawdown=drawdown;
+            in_position=false;
+           }
+        }
+      //--- entries
+      if(!in_position)
+        {
+         bool buy=(rsi<set.rsi_oversold);
+         bool sell=(rsi>set.rsi_overbought);
+         if(buy || sell)
+           {
+            is_buy=buy;
+            entry=price;
+            if(trend)
+               risk=combo.risk_trend;
+            else if(breakout)
+               risk=combo.risk_breakout;
+            double sl_distance=atr*combo.sl_atr;
+            double tp_distance=sl_distance*combo.tp_ratio;
+            stop_loss  =buy ? price-sl_distance : price+sl_distance;
+            take_profit=buy ? price+tp_distance : price-tp_distance;
+            lot_size=OptimizerLotSize(set,res.final_balance,risk,sl_distance/set.pip_value);
+            in_position=true;
+           }
+        }
+      //--- early pruning: enough trades to judge and already below the minimum win rate
+      if(i==checkpoint && res.total_trades>=set.min_trades &&
+         100.0*res.winning_trades/res.total_trades<set.min_win_rate)
+        {
+         res.pruned=1;
+         return;
+        }
+     }
+//--- metrics
+   const double start=set.starting_balance;
+   const int    losing=res.total_trades-res.winning_trades;
+   res.net_profit=res.final_balance-start;
+   res.win_rate=res.total_trades>0 ? (double)res.winning_trades/res.total_trades*100 : 0;
+   res.profit_factor=res.gross_loss>0 ? res.gross_profit/res.gross_loss : 0;
+   res.max_drawdown_percent=start>0 ? res.max_drawdown/start*100 : 0;
+   res.avg_win=res.winning_trades>0 ? res.gross_profit/res.winning_trades : 0;
+   res.avg_loss=losing>0 ? res.gross_loss/losing : 0;
+   res.risk_reward=res.avg_loss>0 ? res.avg_win/res.avg_loss : 0;
+   res.expectancy=(res.win_rate/100*res.avg_win)-((100-res.win_rate)/100*res.avg_loss);
+   res.sharpe_ratio=res.max_drawdown_percent>0 ? res.net_profit/res.max_drawdown_percent : 0;
+   if(res.total_trades>=set.min_trades && res.win_rate>=set.min_win_rate)
+      res.custom_score=res.net_profit*0.4+res.profit_factor*1000*0.3+res.win_rate*10*0.2+(100-res.max_drawdown_percent)*0.1;
+   res.valid=(res.total_trades>=set.min_trades);
+  }
+//+------------------------------------------------------------------+
+//| Work-stealing scheduler                                          |
+//| A slice is packed into one 64-bit word (next | end<<32) so owner |
+//| pops and thief splits are single compare-and-swap operations.    |
+//+------------------------------------------------------------------+
+struct OptimizerJob
+  {
+   const OptimizerBars     *bars;
+   const OptimizerSettings *settings;
+   const OptimizerCombo    *combos;
+   OptimizerResult         *results;
+   volatile LONG64          slices[OPT_MAX_THREADS];
+   int                      workers;
+   volatile LONG            next_worker;
+  };
+//---
+static inline LONG64 SlicePack(const int next,const int end)
+  {
+   return((LONG64)(unsigned)next|((LONG64)end<<32));
+  }
+//---
+static inline int SliceNext(const LONG64 slice) { return(int(slice&0xFFFFFFFF)); }
+static inline int SliceEnd(const LONG64 slice)  { return(int(slice>>32));        }
+//--- take the front combination of the own slice, -1 when it is empty
+static int SlicePop(volatile LONG64 *slice)
+  {
+   for(;;)
+     {
+      LONG64 cur=*slice;
+      int next=SliceNext(cur),end=SliceEnd(cur);
+      if(next>=end)
+         return(-1);
+      if(InterlockedCompareExchange64(slice,SlicePack(next+1,end),cur)==cur)
+         return(next);
+     }
+  }
+//--- move the back half of the fullest other slice into 'self'
+static bool SliceSteal(OptimizerJob &job,const int self)
+  {
+   for(;;)
+     {
+      int    victim=-1,best=1;
+      LONG64 cur=0;
+      for(int w=0; w<job.workers; w++)
+        {
+         LONG64 slice=job.slices[w];
+         int    left=SliceEnd(slice)-SliceNext(slice);
+         if(w!=self && left>best)
+           {
+            best=left;
+            victim=w;
+            cur=slice;
+           }
+        }
+      //--- single combinations are left to their owners
+      if(victim<0)
+         return(false);
+      int next=SliceNext(cur),end=SliceEnd(cur);
+      int split=end-(end-next)/2;
+      if(InterlockedCompareExchange64(&job.slices[victim],SlicePack(next,split),cur)==cur)
+        {
+         InterlockedExchange64(&job.slices[self],SlicePack(split,end));
+         return(true);
+        }
+     }
+  }
+//---
+static DWORD WINAPI OptimizerWorker(LPVOID param)
+  {
+   OptimizerJob &job=*(OptimizerJob *)param;
+   int self=InterlockedIncrement(&job.next_worker)-1;
+//---
+   for(;;)
+     {
+      int index=SlicePop(&job.slices[self]);
+      if(index<0)
+        {
+         if(!SliceSteal(job,self))
+            break;
+         continue;
+        }
+      OptimizerRun(*job.bars,*job.settings,job.combos[index],job.results[index]);
+     }
+   return(0);
+  }
+//+------------------------------------------------------------------+
+//| Ranking by the selected score, ties in grid order                |
+//+------------------------------------------------------------------+
+struct OptimizerRankItem
+  {
+   double            score;
+   int               index;
+  };
+//---
+static int CompareRank(const void *left,const void *right)
+  {
+   const OptimizerRankItem *l=(const OptimizerRankItem *)left;
+   const OptimizerRankItem *r=(const OptimizerRankItem *)right;
+   if(l->score!=r->score)
+      return(l->score>r->score ? -1 : 1);
+   return(l->index-r->index);
+  }
+//---
+static double OptimizerScore(const OptimizerResult &res,const int mode)
+  {
+   switch(mode)
+     {
+      case OPT_MODE_PROFIT_FACTOR: return(res.profit_factor);
+      case OPT_MODE_SHARPE:        return(res.sharpe_ratio);
+      case OPT_MODE_CUSTOM:        return(res.custom_score);
+     }
+   return(res.net_profit);
+  }
+//+------------------------------------------------------------------+
+//| Common driver for both exports                                   |
+//+------------------------------------------------------------------+
+static int OptimizeBars(const char *caller,const OptimizerBars &prices,const OptimizerSettings *settings,
+                        const OptimizerCombo *combos,const int combos_total,
+                        OptimizerResult *results,int *ranking,int threads)
+  {
+//---
+   if(settings==NULL || combos==NULL || results==NULL || ranking==NULL || combos_total<=0)
+     {
+      printf("%s: NULL array or empty grid\n",caller);
+      return(-1);
+     }
+   if(settings->first_bar<1 || settings->rsi_period<1 || settings->atr_period<1 || settings->regime_period<1)
+     {
+      printf("%s: wrong periods\n",caller);
+      return(-1);
+     }
+   if(threads<=0)
+     {
+      SYSTEM_INFO info;
+      GetSystemInfo(&info);
+      threads=int(info.dwNumberOfProcessors);
+     }
+   if(threads>OPT_MAX_THREADS)
+      threads=OPT_MAX_THREADS;
+   if(threads>combos_total)
+      threads=combos_total;
+   if(threads<1)
+      threads=1;
+//--- OptimizerJob holds the slices, keep it off the MQL thread stack
+   OptimizerJob *job=(OptimizerJob *)calloc(1,sizeof(OptimizerJob));
+   OptimizerRankItem *items=(OptimizerRankItem *)malloc(sizeof(OptimizerRankItem)*size_t(combos_total));
+   double *series=(double *)malloc(sizeof(double)*size_t(prices.total)*4);
+   if(job==NULL || items==NULL || series==NULL)
+     {
+      printf("%s: cannot allocate %d combinations\n",caller,combos_total);
+      free(job);
+      free(items);
+      free(series);
+      return(-1);
+     }
+//--- indicators once for the whole grid, read-only from here on
+   OptimizerBars bars=prices;
+   double *rsi=series,*atr=series+prices.total,*avg_atr=atr+prices.total;
+   OptimizerRSI(prices.close,prices.total,settings->rsi_period,rsi);
+   OptimizerATR(prices,settings->atr_period,settings->regime_period,avg_atr+prices.total,atr,avg_atr);
+   bars.rsi=rsi;
+   bars.atr=atr;
+   bars.avg_atr=avg_atr;
+   job->bars=&bars;
+   job->settings=settings;
+   job->combos=combos;
+   job->results=results;
+   job->workers=threads;
+   for(int w=0; w<threads; w++)
+      job->slices[w]=SlicePack(int((__int64)combos_total*w/threads),int((__int64)combos_total*(w+1)/threads));
+//---
+   HANDLE handles[OPT_MAX_THREADS];
+   int    created=0;
+   for(int w=1; w<threads; w++)
+     {
+      handles[created]=CreateThread(NULL,0,OptimizerWorker,job,0,NULL);
+      if(handles[created]!=NULL)
+         created++;
+     }
+//--- the calling thread works too; slices of threads that failed to start get stolen
+   OptimizerWorker(job);
+   if(created>0)
+      WaitForMultipleObjects(created,handles,TRUE,INFINITE);
+   for(int w=0; w<created; w++)
+      CloseHandle(handles[w]);
+//--- a worker that never started leaves its slice for the survivors, finish it here
+   for(int w=0; w<threads; w++)
+     {
+      int index;
+      while((index=SlicePop(&job->slices[w]))>=0)
+         OptimizerRun(bars,*settings,combos[index],results[index]);
+     }
+   free(job);
+   free(series);
+//---
+   int ranked=0;
+   for(int i=0; i<combos_total; i++)
+     {
+      if(results[i].valid && !results[i].pruned)
+        {
+         items[ranked].score=OptimizerScore(results[i],settings->mode);
+         items[ranked].index=i;
+         ranked++;
+        }
+     }
+   qsort(items,ranked,sizeof(OptimizerRankItem),CompareRank);
+   for(int i=0; i<ranked; i++)
+      ranking[i]=items[i].index;
+   free(items);
+//---
+   return(ranked);
+  }
+//+------------------------------------------------------------------+
+//| Optimizes over an MqlRates array (ascending, as CopyRates).      |
+//| results[i] belongs to combos[i]; ranking receives the indices of |
+//| valid, unpruned results, best first. Both arrays must hold       |
+//| combos_total elements. threads=0 uses every CPU.                 |
+//| Returns the number of ranked results or -1.                      |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall OptimizeGrid(const RateInfo *rates,const int rates_total,
+                                       const OptimizerSettings *settings,
+                                       const OptimizerCombo *combos,const int combos_total,
+                                       OptimizerResult *results,int *ranking,const int threads)
+  {
+//---
+   if(rates==NULL || rates_total<=0)
+     {
+      printf("OptimizeGrid: wrong rates (%d)\n",rates_total);
+      return(-1);
+     }
+//--- split once into columns shared read-only by all workers
+   double *memory=(double *)malloc(sizeof(double)*size_t(rates_total)*3);
+   if(memory==NULL)
+     {
+      printf("OptimizeGrid: cannot allocate %d bars\n",rates_total);
+      return(-1);
+     }
+   double *high=memory,*low=memory+rates_total,*close=memory+2*size_t(rates_total);
+   for(int i=0; i<rates_total; i++)
+     {
+      high[i] =rates[i].high;
+      low[i]  =rates[i].low;
+      close[i]=rates[i].close;
+     }
+   OptimizerBars bars={ high,low,close,NULL,NULL,NULL,rates_total };
+   int ranked=OptimizeBars("OptimizeGrid",bars,settings,combos,combos_total,results,ranking,threads);
+   free(memory);
+//---
+   return(ranked);
+  }
+//+------------------------------------------------------------------+
+//| Same as OptimizeGrid, scanning bars [start, start+count) of an   |
+//| open bar cache in place (see DLLBarCache.cpp), without copies.   |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall OptimizeGridCache(const int cache_handle,const int start,const int count,
+                                            const OptimizerSettings *settings,
+                                            const OptimizerCombo *combos,const int combos_total,
+                                            OptimizerResult *results,int *ranking,const int threads)
+  {
+   BarCacheView view;
+//---
+   if(!BarCacheGetView(cache_handle,view))
+     {
+      printf("OptimizeGridCache: invalid cache handle (%d)\n",cache_handle);
+      return(-1);
+     }
+   if(start<0 || count<=0 || start>=view.count)
+     {
+      printf("OptimizeGridCache: wrong range (start %d, count %d of %d)\n",start,count,view.count);
+      return(-1);
+     }
+   int total=(count<view.count-start ? count : view.count-start);
+   OptimizerBars bars={ view.high+start,view.low+start,view.close+start,NULL,NULL,NULL,total };
+//---
+   return(OptimizeBars("OptimizeGridCache",bars,settings,combos,combos_total,results,ranking,threads));
+  }
+//+------------------------------------------------------------------+
@@ -0,0 +1,556 @@
+//+------------------------------------------------------------------+
+//|                          Event-driven replay position simulator |
+//|                             Copyright 2000-2024, MetaQuotes Ltd. |
+//|                                               www.metaquotes.net |
+//+------------------------------------------------------------------+
+//| Fills stops and targets for a replayed bar or tick stream and    |
+//| keeps the account. The MQL side (GrandeReplayEngine.mqh) runs    |
+//| the Grande detectors on each replayed bar and opens, modifies    |
+//| and closes positions here, so the decision code stays the EA's   |
+//| and only the order simulation is native.                         |
+//|                                                                  |
+//| Open positions live in preallocated columns (id, side, time,     |
+//| entry, stop, target, lots). A close moves the last position into |
+//| the freed slot, so every step scans dense columns and no trade   |
+//| allocates. Closed trades go to a log that doubles when full.     |
+//|                                                                  |
+//| Intrabar fills. Bar prices are bid; asks add the bar spread (or  |
+//| the configured one). A bar is walked open-low-high-close when it |
+//| closed up and open-high-low-close when it closed down. Buys exit |
+//| on the bid, sells on the ask. A level crossed between two path   |
+//| points fills at the level; a level already passed at a point (a  |
+//| gap at the open, or any tick) fills at that point's price. Stop  |
+//| fills lose the configured slippage on top.                       |
+//|                                                                  |
+//| A session belongs to one MQL program; only the handle table is   |
+//| locked. Exports return -1 on wrong arguments or a bad handle.    |
+//+------------------------------------------------------------------+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "DLLSample.h"
+//---
+#define REPLAY_MAX_OPEN        16
+#define REPLAY_MAX_CAPACITY    65536
+#define REPLAY_TRADES_INITIAL  1024
+#define REPLAY_TICK_CHUNK      256
+//+------------------------------------------------------------------+
+//| Replay session                                                   |
+//+------------------------------------------------------------------+
+struct ReplaySession
+  {
+   ReplaySettings    settings;
+   //--- open positions: 'capacity' entries per column, first 'count' used
+   int               count;
+   __int64          *open_time;
+   double           *entry;
+   double           *stop_loss;
+   double           *take_profit;
+   double           *lots;
+   int              *id;
+   int              *is_buy;
+   void             *columns;
+   //--- closed trades, oldest first
+   ReplayTrade      *trades;
+   int               trades_count;
+   int               trades_capacity;
+   //--- account
+   ReplayStats       stats;
+   double            value_per_price;   // tick_value/tick_size
+   double            last_bid;
+   double            last_ask;
+   __int64           last_time;
+   int               next_id;
+  };
+//--- handle N lives in ExtReplays[N-1]; NULL marks a free slot
+static ReplaySession *ExtReplays[REPLAY_MAX_OPEN];
+static SRWLOCK        ExtReplaysLock=SRWLOCK_INIT;
+//---
+static ReplaySession *ReplayGet(const int handle)
+  {
+   ReplaySession *session=NULL;
+//---
+   AcquireSRWLockShared(&ExtReplaysLock);
+   if(handle>=1 && handle<=REPLAY_MAX_OPEN)
+      session=ExtReplays[handle-1];
+   ReleaseSRWLockShared(&ExtReplaysLock);
+//---
+   return(session);
+  }
+//---
+static void ReplayFree(ReplaySession *session)
+  {
+   if(session==NULL)
+      return;
+   free(session->columns);
+   free(session->trades);
+   free(session);
+  }
+//+------------------------------------------------------------------+
+//| Money                                                            |
+//+------------------------------------------------------------------+
+static double ReplayProfit(const ReplaySession &s,const int index,const double price)
+  {
+   double diff=s.is_buy[index] ? price-s.entry[index] : s.entry[index]-price;
+   return(s.value_per_price*diff*s.lots[index]);
+  }
+//--- equity at the last quote, then peak and drawdown
+static void ReplayMark(ReplaySession &s)
+  {
+   double open_profit=0.0;
+   for(int i=0; i<s.count; i++)
+      open_profit+=ReplayProfit(s,i,s.is_buy[i] ? s.last_bid : s.last_ask);
+//---
+   ReplayStats &st=s.stats;
+   st.equity=st.balance+open_profit;
+   st.open_positions=s.count;
+   if(st.equity>st.peak_equity)
+      st.peak_equity=st.equity;
+   double drawdown=st.peak_equity-st.equity;
+   if(drawdown>st.max_drawdown)
+     {
+      st.max_drawdown=drawdown;
+      st.max_drawdown_percent=(st.peak_equity>0 ? drawdown/st.peak_equity*100.0 : 0.0);
+     }
+  }
+//+------------------------------------------------------------------+
+//| Closes position 'index' at 'price' and books the trade           |
+//+------------------------------------------------------------------+
+static void ReplayCloseAt(ReplaySession &s,const int index,const __int64 time,const double price,const int reason)
+  {
+   const double commission=s.settings.commission_per_lot*s.lots[index];
+   const double profit=ReplayProfit(s,index,price)-commission;
+//---
+   ReplayStats &st=s.stats;
+   st.balance   +=profit;
+   st.commission+=commission;
+   st.total_trades++;
+   if(profit>0)
+     {
+      st.winning_trades++;
+      st.gross_profit+=profit;
+     }
+   else
+     {
+      st.losing_trades++;
+      st.gross_loss-=profit;
+     }
+//--- the account is booked even if the log cannot grow
+   if(s.trades_count==s.trades_capacity)
+     {
+      int capacity=s.trades_capacity*2;
+      ReplayTrade *grown=(ReplayTrade *)realloc(s.trades,sizeof(ReplayTrade)*size_t(capacity));
+      if(grown!=NULL)
+        {
+         s.trades=grown;
+         s.trades_capacity=capacity;
+        }
+     }
+   if(s.trades_count<s.trades_capacity)
+     {
+      ReplayTrade &trade=s.trades[s.trades_count++];
+      trade.open_time  =s.open_time[index];
+      trade.close_time =time;
+      trade.entry      =s.entry[index];
+      trade.exit       =price;
+      trade.stop_loss  =s.stop_loss[index];
+      trade.take_profit=s.take_profit[index];
+      trade.lots       =s.lots[index];
+      trade.profit     =profit;
+      trade.id         =s.id[index];
+      trade.is_buy     =s.is_buy[index];
+      trade.exit_reason=reason;
+      trade.reserved   =0;
+     }
+//--- keep the columns dense
+   const int last=--s.count;
+   if(index!=last)
+     {
+      s.open_time[index]  =s.open_time[last];
+      s.entry[index]      =s.entry[last];
+      s.stop_loss[index]  =s.stop_loss[last];
+      s.take_profit[index]=s.take_profit[last];
+      s.lots[index]       =s.lots[last];
+      s.id[index]         =s.id[last];
+      s.is_buy[index]     =s.is_buy[last];
+     }
+  }
+//+------------------------------------------------------------------+
+//| Walks every open position along a price path. 'continuous' paths |
+//| (bar OHLC) pass through every price between two points, so a     |
+//| crossing fills at the level; tick paths jump and fill at the     |
+//| tick. Returns the number of positions closed.                    |
+//+------------------------------------------------------------------+
+static int ReplayWalk(ReplaySession &s,const double *bid,const double *ask,const __int64 *time,
+                      const int points,const bool continuous)
+  {
+   const double slippage=s.settings.stop_slippage;
+   int closed=0;
+//---
+   for(int i=0; i<s.count;)
+     {
+      const bool    buy=(s.is_buy[i]!=0);
+      const double *price=(buy ? bid : ask);
+      const double  sl=s.stop_loss[i];
+      const double  tp=s.take_profit[i];
+      int    reason=REPLAY_EXIT_NONE;
+      double fill=0.0;
+      int    k;
+      for(k=0; k<points; k++)
+        {
+         const double p=price[k];
+         const bool   crossed=(continuous && k>0);
+         if(sl>0.0 && (buy ? p<=sl : p>=sl))
+           {
+            reason=REPLAY_EXIT_STOP_LOSS;
+            fill=(crossed ? sl : p)+(buy ? -slippage : slippage);
+            break;
+           }
+         if(tp>0.0 && (buy ? p>=tp : p<=tp))
+           {
+            reason=REPLAY_EXIT_TAKE_PROFIT;
+            fill=(crossed ? tp : p);
+            break;
+           }
+        }
+      if(reason==REPLAY_EXIT_NONE)
+        {
+         i++;
+         continue;
+        }
+      //--- slot i now holds the former last position; look at it next
+      ReplayCloseAt(s,i,time[k],fill,reason);
+      closed++;
+     }
+//---
+   s.last_bid =bid[points-1];
+   s.last_ask =ask[points-1];
+   s.last_time=time[points-1];
+   ReplayMark(s);
+   return(closed);
+  }
+//---
+static int ReplayFind(const ReplaySession &s,const int id)
+  {
+   for(int i=0; i<s.count; i++)
+      if(s.id[i]==id)
+         return(i);
+   return(-1);
+  }
+//+------------------------------------------------------------------+
+//| Creates a session with room for settings->capacity open          |
+//| positions. Returns a handle or -1.                               |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayCreate(const ReplaySettings *settings)
+  {
+//---
+   if(settings==NULL || settings->tick_size<=0 || settings->tick_value<=0 || settings->point<=0)
+     {
+      printf("ReplayCreate: wrong settings\n");
+      return(-1);
+     }
+   if(settings->capacity<=0 || settings->capacity>REPLAY_MAX_CAPACITY)
+     {
+      printf("ReplayCreate: wrong capacity (%d)\n",settings->capacity);
+      return(-1);
+     }
+//---
+   ReplaySession *session=(ReplaySession *)calloc(1,sizeof(ReplaySession));
+   if(session==NULL)
+      return(-1);
+   const size_t capacity=size_t(settings->capacity);
+   session->settings=*settings;
+   session->columns=malloc(capacity*(sizeof(__int64)+sizeof(double)*5+sizeof(int)*2));
+   session->trades=(ReplayTrade *)malloc(sizeof(ReplayTrade)*REPLAY_TRADES_INITIAL);
+   if(session->columns==NULL || session->trades==NULL)
+     {
+      printf("ReplayCreate: out of memory (%d positions)\n",settings->capacity);
+      ReplayFree(session);
+      return(-1);
+     }
+//--- 8-byte columns first, so every column stays aligned
+   session->open_time  =(__int64 *)session->columns;
+   session->entry      =(double *)(session->open_time+capacity);
+   session->stop_loss  =session->entry+capacity;
+   session->take_profit=session->stop_loss+capacity;
+   session->lots       =session->take_profit+capacity;
+   session->id         =(int *)(session->lots+capacity);
+   session->is_buy     =session->id+capacity;
+   session->trades_capacity=REPLAY_TRADES_INITIAL;
+   session->value_per_price=settings->tick_value/settings->tick_size;
+   session->next_id=1;
+   session->stats.balance    =settings->starting_balance;
+   session->stats.equity     =settings->starting_balance;
+   session->stats.peak_equity=settings->starting_balance;
+//---
+   int handle=-1;
+   AcquireSRWLockExclusive(&ExtReplaysLock);
+   for(int i=0; i<REPLAY_MAX_OPEN; i++)
+     {
+      if(ExtReplays[i]==NULL)
+        {
+         ExtReplays[i]=session;
+         handle=i+1;
+         break;
+        }
+     }
+   ReleaseSRWLockExclusive(&ExtReplaysLock);
+//---
+   if(handle<0)
+     {
+      printf("ReplayCreate: too many sessions (%d)\n",REPLAY_MAX_OPEN);
+      ReplayFree(session);
+     }
+   return(handle);
+  }
+//+------------------------------------------------------------------+
+//| Frees a session. Returns 1, or -1 for an unknown handle.         |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayDestroy(const int handle)
+  {
+   ReplaySession *session=NULL;
+//---
+   AcquireSRWLockExclusive(&ExtReplaysLock);
+   if(handle>=1 && handle<=REPLAY_MAX_OPEN)
+     {
+      session=ExtReplays[handle-1];
+      ExtReplays[handle-1]=NULL;
+     }
+   ReleaseSRWLockExclusive(&ExtReplaysLock);
+//---
+   if(session==NULL)
+      return(-1);
+   ReplayFree(session);
+   return(1);
+  }
+//+------------------------------------------------------------------+
+//| Opens a position. price<=0 fills at the last replayed quote (buy |
+//| at the ask, sell at the bid). Returns the position id, 0 when    |
+//| the pool is full, or -1.                                         |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayOpenPosition(const int handle,const int is_buy,const __int64 time,const double price,
+                                             const double lots,const double stop_loss,const double take_profit)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL || lots<=0)
+     {
+      printf("ReplayOpenPosition: invalid handle (%d) or lots\n",handle);
+      return(-1);
+     }
+   double fill=(price>0 ? price : (is_buy ? s->last_ask : s->last_bid));
+   if(fill<=0)
+     {
+      printf("ReplayOpenPosition: no quote replayed yet\n");
+      return(-1);
+     }
+   if(s->count>=s->settings.capacity)
+     {
+      s->stats.rejected++;
+      return(0);
+     }
+//---
+   const int i=s->count++;
+   s->open_time[i]  =time;
+   s->entry[i]      =fill;
+   s->stop_loss[i]  =stop_loss;
+   s->take_profit[i]=take_profit;
+   s->lots[i]       =lots;
+   s->id[i]         =s->next_id++;
+   s->is_buy[i]     =(is_buy!=0);
+   s->stats.open_positions=s->count;
+   return(s->id[i]);
+  }
+//+------------------------------------------------------------------+
+//| New stop/target for an open position (0 removes it). Returns 1,  |
+//| 0 if the position is closed already, or -1.                      |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayModifyPosition(const int handle,const int id,const double stop_loss,const double take_profit)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL)
+     {
+      printf("ReplayModifyPosition: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   int index=ReplayFind(*s,id);
+   if(index<0)
+      return(0);
+   s->stop_loss[index]  =stop_loss;
+   s->take_profit[index]=take_profit;
+   return(1);
+  }
+//+------------------------------------------------------------------+
+//| Closes a position at the last quote (price<=0) or at 'price'.    |
+//| Returns 1, 0 if it is closed already, or -1.                     |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayClosePosition(const int handle,const int id,const __int64 time,const double price)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL)
+     {
+      printf("ReplayClosePosition: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   int index=ReplayFind(*s,id);
+   if(index<0)
+      return(0);
+   double fill=(price>0 ? price : (s->is_buy[index] ? s->last_bid : s->last_ask));
+   ReplayCloseAt(*s,index,time,fill,REPLAY_EXIT_MANUAL);
+   ReplayMark(*s);
+   return(1);
+  }
+//+------------------------------------------------------------------+
+//| Closes every open position at the last quote with 'reason'.      |
+//| Returns the number closed.                                       |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayCloseAll(const int handle,const int reason)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL)
+     {
+      printf("ReplayCloseAll: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   int closed=0;
+   while(s->count>0)
+     {
+      const int last=s->count-1;
+      ReplayCloseAt(*s,last,s->last_time,s->is_buy[last] ? s->last_bid : s->last_ask,reason);
+      closed++;
+     }
+   ReplayMark(*s);
+   return(closed);
+  }
+//+------------------------------------------------------------------+
+//| Replays one bar with the OHLC path model. Returns the number of  |
+//| positions closed on it.                                          |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayStepBar(const int handle,const RateInfo *bar)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL || bar==NULL)
+     {
+      printf("ReplayStepBar: invalid handle (%d) or NULL bar\n",handle);
+      return(-1);
+     }
+   double spread=s->settings.spread;
+   if(s->settings.use_bar_spread && bar->spread>0)
+      spread=bar->spread*s->settings.point;
+//---
+   const bool up=(bar->close>=bar->open);
+   double     bid[4]={ bar->open,up ? bar->low : bar->high,up ? bar->high : bar->low,bar->close };
+   double     ask[4];
+   __int64    time[4];
+   for(int k=0; k<4; k++)
+     {
+      ask[k] =bid[k]+spread;
+      time[k]=bar->ctm;
+     }
+   s->stats.bars++;
+   return(ReplayWalk(*s,bid,ask,time,4,true));
+  }
+#ifdef _WIN64
+//+------------------------------------------------------------------+
+//| Replays ticks in CopyTicks order. Ticks without a two-sided      |
+//| quote are skipped. Returns the number of positions closed.       |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayStepTicks(const int handle,const MqlTick *ticks,const int ticks_total)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL || ticks==NULL || ticks_total<0)
+     {
+      printf("ReplayStepTicks: invalid handle (%d) or ticks\n",handle);
+      return(-1);
+     }
+   double  bid[REPLAY_TICK_CHUNK],ask[REPLAY_TICK_CHUNK];
+   __int64 time[REPLAY_TICK_CHUNK];
+   int     closed=0,points=0;
+   for(int i=0; i<ticks_total; i++)
+     {
+      if(ticks[i].bid<=0 || ticks[i].ask<=0)
+         continue;
+      bid[points] =ticks[i].bid;
+      ask[points] =ticks[i].ask;
+      time[points]=ticks[i].time;
+      s->stats.ticks++;
+      if(++points==REPLAY_TICK_CHUNK)
+        {
+         closed+=ReplayWalk(*s,bid,ask,time,points,false);
+         points=0;
+        }
+     }
+   if(points>0)
+      closed+=ReplayWalk(*s,bid,ask,time,points,false);
+   return(closed);
+  }
+#endif
+//+------------------------------------------------------------------+
+//| Copies up to 'size' open positions. Returns the open count.      |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayGetPositions(const int handle,ReplayPosition *positions,const int size)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL || size<0 || (positions==NULL && size>0))
+     {
+      printf("ReplayGetPositions: invalid handle (%d) or buffer\n",handle);
+      return(-1);
+     }
+   for(int i=0; i<s->count && i<size; i++)
+     {
+      ReplayPosition &p=positions[i];
+      p.open_time  =s->open_time[i];
+      p.entry      =s->entry[i];
+      p.stop_loss  =s->stop_loss[i];
+      p.take_profit=s->take_profit[i];
+      p.lots       =s->lots[i];
+      p.profit     =ReplayProfit(*s,i,s->is_buy[i] ? s->last_bid : s->last_ask);
+      p.id         =s->id[i];
+      p.is_buy     =s->is_buy[i];
+     }
+   return(s->count);
+  }
+//+------------------------------------------------------------------+
+//| Copies closed trades [start, start+size). Returns the number     |
+//| copied.                                                          |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayGetTrades(const int handle,const int start,ReplayTrade *trades,const int size)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL || start<0 || size<0 || (trades==NULL && size>0))
+     {
+      printf("ReplayGetTrades: invalid handle (%d) or range\n",handle);
+      return(-1);
+     }
+   int count=s->trades_count-start;
+   if(count>size)
+      count=size;
+   if(count<=0)
+      return(0);
+   memcpy(trades,s->trades+start,sizeof(ReplayTrade)*size_t(count));
+   return(count);
+  }
+//+------------------------------------------------------------------+
+//| Account and counters. Returns 1.                                 |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall ReplayGetStats(const int handle,ReplayStats *stats)
+  {
+   ReplaySession *s=ReplayGet(handle);
+//---
+   if(s==NULL || stats==NULL)
+     {
+      printf("ReplayGetStats: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   *stats=s->stats;
+   return(1);
+  }
+//+------------------------------------------------------------------+
@@ -6,31 +6,8 @@
 #include <windows.h>
 #include <stdlib.h>
 #include <stdio.h>
-//---
-#define MT4_EXPFUNC __declspec(dllexport)
-//+------------------------------------------------------------------+
-//|                                                                  |
-//+------------------------------------------------------------------+
-#pragma pack(push,1)
-struct RateInfo
-  {
-   __int64           ctm;
-   double            open;
-   double            low;
-   double            high;
-   double            close;
-   unsigned __int64  vol_tick;
-   int               spread;
-   unsigned __int64  vol_real;
-  };
-#pragma pack(pop)
-//---
-struct MqlStr
-  {
-   int               len;
-   char             *string;
-  };
-static int CompareMqlStr(const void *left,const void *right);
+#include <stddef.h>
+#include "DLLSample.h"
 //+------------------------------------------------------------------+
 //|                                                                  |
 //+------------------------------------------------------------------+
@@ -165,6 +142,500 @@ MT4_EXPFUNC double __stdcall GetRatesItemValue(const RateInfo* rates,const int r
    return(0.0);
   }
 //+------------------------------------------------------------------+
+//| Bulk rates access                                                |
+//| Every batch export validates its arguments once, resolves the    |
+//| requested field once and then runs a tight loop over the packed  |
+//| RateInfo array. Output buffers are filled in series order:       |
+//| buffer[0] is the bar at 'shift', buffer[1] the bar at shift+1... |
+//| Return value is the number of elements written or -1 on error.   |
+//| Field indices are the RATE_* constants from DLLSample.h.         |
+//+------------------------------------------------------------------+
+//---
+//+------------------------------------------------------------------+
+//| Validates common bulk arguments and returns the number of bars   |
+//| which can be copied, or -1 if arguments are wrong                |
+//+------------------------------------------------------------------+
+static int RatesBulkCount(const char *func,const RateInfo *rates,const int rates_total,
+                          const int shift,const int count,const int buffer_size)
+  {
+   if(rates==NULL)
+     {
+      printf("%s: NULL array\n",func);
+      return(-1);
+     }
+   if(rates_total<=0)
+     {
+      printf("%s: wrong rates_total number (%d)\n",func,rates_total);
+      return(-1);
+     }
+   if(shift<0 || shift>=rates_total)
+     {
+      printf("%s: wrong shift number (%d)\n",func,shift);
+      return(-1);
+     }
+   if(count<=0 || buffer_size<=0)
+     {
+      printf("%s: wrong count (%d) or buffer size (%d)\n",func,count,buffer_size);
+      return(-1);
+     }
+//--- clip to available bars and to the caller buffer
+   int total=count;
+   if(total>rates_total-shift)
+      total=rates_total-shift;
+   if(total>buffer_size)
+      total=buffer_size;
+//---
+   return(total);
+  }
+//+------------------------------------------------------------------+
+//| Copies one field (or a derived price) for 'count' bars starting  |
+//| at 'shift' into buffer                                           |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall GetRatesSeries(const RateInfo *rates,const int rates_total,const int shift,
+                                         const int count,const int nrate,double *buffer,const int buffer_size)
+  {
+//---
+   int total=RatesBulkCount("GetRatesSeries",rates,rates_total,shift,count,buffer_size);
+   if(total<0)
+      return(-1);
+   if(buffer==NULL)
+     {
+      printf("GetRatesSeries: NULL buffer\n");
+      return(-1);
+     }
+   if(nrate<0 || nrate>RATE_LAST)
+     {
+      printf("GetRatesSeries: wrong rate index (%d)\n",nrate);
+      return(-1);
+     }
+//--- src walks backwards from the bar at 'shift' towards older bars
+   const RateInfo *src=rates+(rates_total-1-shift);
+   int i;
+   switch(nrate)
+     {
+      case RATE_TIME:
+         for(i=0; i<total; i++)
+            buffer[i]=double(src[-i].ctm);
+         break;
+      case RATE_OPEN:
+         for(i=0; i<total; i++)
+            buffer[i]=src[-i].open;
+         break;
+      case RATE_LOW:
+         for(i=0; i<total; i++)
+            buffer[i]=src[-i].low;
+         break;
+      case RATE_HIGH:
+         for(i=0; i<total; i++)
+            buffer[i]=src[-i].high;
+         break;
+      case RATE_CLOSE:
+         for(i=0; i<total; i++)
+            buffer[i]=src[-i].close;
+         break;
+      case RATE_VOLUME:
+         for(i=0; i<total; i++)
+            buffer[i]=double(src[-i].vol_tick);
+         break;
+      case RATE_MEDIAN:
+         for(i=0; i<total; i++)
+            buffer[i]=(src[-i].high+src[-i].low)*0.5;
+         break;
+      case RATE_TYPICAL:
+         for(i=0; i<total; i++)
+            buffer[i]=(src[-i].high+src[-i].low+src[-i].close)/3.0;
+         break;
+      case RATE_WEIGHTED:
+         for(i=0; i<total; i++)
+            buffer[i]=(src[-i].high+src[-i].low+2.0*src[-i].close)*0.25;
+         break;
+      case RATE_TRUE_RANGE:
+        {
+         //--- the oldest bar in the whole history has no previous close
+         int oldest=rates_total-1-shift;
+         for(i=0; i<total; i++)
+           {
+            double high=src[-i].high;
+            double low =src[-i].low;
+            if(i<oldest)
+              {
+               double prev_close=src[-i-1].close;
+               if(prev_close>high)
+                  high=prev_close;
+               if(prev_close<low)
+                  low=prev_close;
+              }
+            buffer[i]=high-low;
+           }
+        }
+      break;
+     }
+//---
+   return(total);
+  }
+//+------------------------------------------------------------------+
+//| Copies open/high/low/close for 'count' bars in a single pass.    |
+//| Any of the output buffers may be NULL if it is not needed.       |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall GetRatesOHLC(const RateInfo *rates,const int rates_total,const int shift,const int count,
+                                       double *open,double *high,double *low,double *close,const int buffer_size)
+  {
+//---
+   int total=RatesBulkCount("GetRatesOHLC",rates,rates_total,shift,count,buffer_size);
+   if(total<0)
+      return(-1);
+   if(open==NULL && high==NULL && low==NULL && close==NULL)
+     {
+      printf("GetRatesOHLC: no output buffers\n");
+      return(-1);
+     }
+//---
+   const RateInfo *src=rates+(rates_total-1-shift);
+   for(int i=0; i<total; i++)
+     {
+      const RateInfo *bar=src-i;
+      if(open!=NULL)
+         open[i]=bar->open;
+      if(high!=NULL)
+         high[i]=bar->high;
+      if(low!=NULL)
+         low[i]=bar->low;
+      if(close!=NULL)
+         close[i]=bar->close;
+     }
+//---
+   return(total);
+  }
+#ifdef _WIN64
+//+------------------------------------------------------------------+
+//| Copies one MqlTick field for the whole CopyTicks() result.       |
+//| Output keeps the CopyTicks order: buffer[i] belongs to ticks[i]. |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall GetTicksSeries(const MqlTick *ticks,const int ticks_total,const int nfield,
+                                         double *buffer,const int buffer_size)
+  {
+//---
+   if(ticks==NULL || buffer==NULL)
+     {
+      printf("GetTicksSeries: NULL array\n");
+      return(-1);
+     }
+   if(ticks_total<=0 || buffer_size<=0)
+     {
+      printf("GetTicksSeries: wrong ticks_total (%d) or buffer size (%d)\n",ticks_total,buffer_size);
+      return(-1);
+     }
+   if(nfield<0 || nfield>TICK_FIELD_LAST)
+     {
+      printf("GetTicksSeries: wrong tick field (%d)\n",nfield);
+      return(-1);
+     }
+//---
+   int total=(ticks_total<buffer_size ? ticks_total : buffer_size);
+   int i;
+   switch(nfield)
+     {
+      case TICK_TIME_MSC:
+         for(i=0; i<total; i++)
+            buffer[i]=double(ticks[i].time_msc);
+         break;
+      case TICK_BID:
+         for(i=0; i<total; i++)
+            buffer[i]=ticks[i].bid;
+         break;
+      case TICK_ASK:
+         for(i=0; i<total; i++)
+            buffer[i]=ticks[i].ask;
+         break;
+      case TICK_LAST:
+         for(i=0; i<total; i++)
+            buffer[i]=ticks[i].last;
+         break;
+      case TICK_VOLUME:
+         for(i=0; i<total; i++)
+            buffer[i]=ticks[i].volume_real;
+         break;
+      case TICK_SPREAD:
+         for(i=0; i<total; i++)
+            buffer[i]=ticks[i].ask-ticks[i].bid;
+         break;
+      case TICK_MID:
+         for(i=0; i<total; i++)
+            buffer[i]=(ticks[i].ask+ticks[i].bid)*0.5;
+         break;
+     }
+//---
+   return(total);
+  }
+#endif
+//+------------------------------------------------------------------+
+//| Describes the build so the MQL side can verify the ABI it loaded |
+//| before passing any structures. 'buffer' receives a wide string   |
+//| (MQL5 string or ushort array), at most buffer_len-1 characters.  |
+//| Returns LIBRARY_ABI_ID of RateInfo as laid out by this build.    |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall GetLibraryInfo(wchar_t *buffer,const int buffer_len)
+  {
+#ifdef _WIN64
+   const wchar_t *info=L"DLLSample x64 MT5 MqlRates/MqlTick";
+#else
+   const wchar_t *info=L"DLLSample Win32 MT4 RateInfo/MqlStr";
+#endif
+//---
+   if(buffer!=NULL && buffer_len>0)
+     {
+      wcsncpy(buffer,info,size_t(buffer_len-1));
+      buffer[buffer_len-1]=L'\0';
+     }
+//---
+   return(LIBRARY_ABI_ID(int(sizeof(RateInfo)),int(offsetof(RateInfo,high)),int(sizeof(void *))));
+  }
+//+------------------------------------------------------------------+
+//| String sorting                                                   |
+//| Multikey quicksort (Bentley-Sedgewick) on MqlStr: partitions on  |
+//| one character at a time, so a common prefix is compared once per |
+//| level instead of once per strcmp() call. NULL strings are moved  |
+//| to the front first, as the former qsort comparator did. Byte     |
+//| order is unsigned, identical to strcmp().                        |
+//+------------------------------------------------------------------+
+#define SORT_INSERTION_CUTOFF   12       // below this size insertion sort wins
+#define SORT_PARALLEL_THRESHOLD 65536    // arrays from this size use threads
+#define SORT_MAX_THREADS        64       // WaitForMultipleObjects limit
+#define SORT_BUCKETS            65536    // two leading bytes
+//---
+static inline int SortCharAt(const MqlStr &str,const int depth)
+  {
+   return((unsigned char)str.string[depth]);
+  }
+//---
+static inline void SortSwap(MqlStr *left,MqlStr *right)
+  {
+   MqlStr tmp=*left;
+   *left=*right;
+   *right=tmp;
+  }
+//---
+static void SortSwapRange(MqlStr *left,MqlStr *right,int count)
+  {
+   while(count-->0)
+      SortSwap(left++,right++);
+  }
+//--- all strings share the first 'depth' characters
+static void SortInsertion(MqlStr *arr,const int count,const int depth)
+  {
+   for(int i=1; i<count; i++)
+      for(int j=i; j>0 && strcmp(arr[j-1].string+depth,arr[j].string+depth)>0; j--)
+         SortSwap(&arr[j-1],&arr[j]);
+  }
+//--- all strings are non-NULL and share the first 'depth' characters
+static void SortMultikey(MqlStr *arr,int count,int depth)
+  {
+   while(count>SORT_INSERTION_CUTOFF)
+     {
+      //--- median of three pivot character, parked at arr[0]
+      int mid=count/2,last=count-1;
+      int c0=SortCharAt(arr[0],depth),cm=SortCharAt(arr[mid],depth),cl=SortCharAt(arr[last],depth);
+      int median=(c0<cm ? (cm<cl ? mid : (c0<cl ? last : 0)) : (c0<cl ? 0 : (cm<cl ? last : mid)));
+      SortSwap(&arr[0],&arr[median]);
+      int pivot=SortCharAt(arr[0],depth);
+      //--- split-end partition: equal keys collect at both ends
+      int a=1,b=1,c=last,d=last;
+      for(;;)
+        {
+         int r;
+         while(b<=c && (r=SortCharAt(arr[b],depth)-pivot)<=0)
+           {
+            if(r==0)
+               SortSwap(&arr[a++],&arr[b]);
+            b++;
+           }
+         while(b<=c && (r=SortCharAt(arr[c],depth)-pivot)>=0)
+           {
+            if(r==0)
+               SortSwap(&arr[c],&arr[d--]);
+            c--;
+           }
+         if(b>c)
+            break;
+         SortSwap(&arr[b++],&arr[c--]);
+        }
+      //--- bring equal keys to the middle
+      int r=(a<b-a ? a : b-a);
+      SortSwapRange(arr,arr+b-r,r);
+      r=(d-c<last-d ? d-c : last-d);
+      SortSwapRange(arr+b,arr+count-r,r);
+      int less=b-a;
+      int greater=d-c;
+      SortMultikey(arr,less,depth);
+      SortMultikey(arr+count-greater,greater,depth);
+      //--- equal strings that already ended need no further work
+      if(pivot==0)
+         return;
+      //--- continue on the equal partition one character deeper
+      arr+=less;
+      count-=less+greater;
+      depth++;
+     }
+   SortInsertion(arr,count,depth);
+  }
+//--- moves NULL strings to the front, returns their number
+static int SortNullsFirst(MqlStr *arr,const int arraysize)
+  {
+   int nulls=0;
+   for(int i=0; i<arraysize; i++)
+      if(arr[i].string==NULL)
+         SortSwap(&arr[nulls++],&arr[i]);
+   return(nulls);
+  }
+//+------------------------------------------------------------------+
+//| Parallel mode: strings are distributed into buckets by their two |
+//| leading bytes, which already orders the buckets, then worker     |
+//| threads take buckets largest first and sort each at depth 2.     |
+//+------------------------------------------------------------------+
+struct SortBucket
+  {
+   int               start;
+   int               count;
+  };
+//---
+struct SortJob
+  {
+   MqlStr           *arr;
+   SortBucket       *buckets;
+   int               total;
+   volatile LONG     next;
+  };
+//---
+static inline int SortBucketKey(const MqlStr &str)
+  {
+   int c0=SortCharAt(str,0);
+   return(c0==0 ? 0 : (c0<<8)|SortCharAt(str,1));
+  }
+//---
+static int CompareBucketSize(const void *left,const void *right)
+  {
+   return(((const SortBucket *)right)->count-((const SortBucket *)left)->count);
+  }
+//---
+static DWORD WINAPI SortWorker(LPVOID param)
+  {
+   SortJob *job=(SortJob *)param;
+   LONG     index;
+//---
+   while((index=InterlockedIncrement(&job->next)-1)<job->total)
+     {
+      SortBucket *bucket=&job->buckets[index];
+      SortMultikey(job->arr+bucket->start,bucket->count,2);
+     }
+   return(0);
+  }
+//--- returns false if resources are missing, the caller then sorts serially
+static bool SortParallel(MqlStr *arr,const int count,int threads)
+  {
+   int        *offsets=(int *)calloc(SORT_BUCKETS+1,sizeof(int));
+   MqlStr     *scratch=(MqlStr *)malloc(sizeof(MqlStr)*size_t(count));
+   SortBucket *buckets=(SortBucket *)malloc(sizeof(SortBucket)*SORT_BUCKETS);
+   HANDLE      handles[SORT_MAX_THREADS];
+   SortJob     job;
+   int         i,created=0;
+//---
+   if(offsets==NULL || scratch==NULL || buckets==NULL)
+     {
+      free(offsets);
+      free(scratch);
+      free(buckets);
+      return(false);
+     }
+//--- counting pass, then stable scatter into bucket order
+   for(i=0; i<count; i++)
+      offsets[SortBucketKey(arr[i])+1]++;
+   for(i=0; i<SORT_BUCKETS; i++)
+      offsets[i+1]+=offsets[i];
+   job.total=0;
+   for(i=0; i<SORT_BUCKETS; i++)
+     {
+      int size=offsets[i+1]-offsets[i];
+      //--- keys with a zero low byte hold strings of length <2, all equal
+      if(size>1 && (i&0xFF)!=0)
+        {
+         buckets[job.total].start=offsets[i];
+         buckets[job.total].count=size;
+         job.total++;
+        }
+     }
+   for(i=0; i<count; i++)
+      scratch[offsets[SortBucketKey(arr[i])]++]=arr[i];
+   memcpy(arr,scratch,sizeof(MqlStr)*size_t(count));
+   free(scratch);
+   free(offsets);
+//--- largest buckets first keeps the workers balanced
+   qsort(buckets,job.total,sizeof(SortBucket),CompareBucketSize);
+   job.arr=arr;
+   job.buckets=buckets;
+   job.next=0;
+   if(threads>job.total)
+      threads=job.total;
+   for(i=1; i<threads; i++)
+     {
+      handles[created]=CreateThread(NULL,0,SortWorker,&job,0,NULL);
+      if(handles[created]!=NULL)
+         created++;
+     }
+//--- the calling thread works too, so a failed CreateThread only costs speed
+   SortWorker(&job);
+   if(created>0)
+      WaitForMultipleObjects(created,handles,TRUE,INFINITE);
+   for(i=0; i<created; i++)
+      CloseHandle(handles[i]);
+   free(buckets);
+//---
+   return(true);
+  }
+//---
+static int SortDefaultThreads(void)
+  {
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   int threads=int(info.dwNumberOfProcessors);
+   return(threads<1 ? 1 : (threads>SORT_MAX_THREADS ? SORT_MAX_THREADS : threads));
+  }
+//--- NULLs first, then threads for large arrays when allowed
+static void SortStrings(MqlStr *arr,const int arraysize,const int workers)
+  {
+   int nulls=SortNullsFirst(arr,arraysize);
+   int count=arraysize-nulls;
+   if(workers<=1 || count<SORT_PARALLEL_THRESHOLD || !SortParallel(arr+nulls,count,workers))
+      SortMultikey(arr+nulls,count,0);
+  }
+//+------------------------------------------------------------------+
+//| Sorts with an explicit thread count: 0 picks the number of CPUs, |
+//| 1 forces the single-threaded path. Arrays below the parallel     |
+//| threshold are always sorted on the calling thread.               |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall SortStringArrayEx(MqlStr *arr,const int arraysize,const int threads)
+  {
+//---
+   if(arr==NULL)
+     {
+      printf("SortStringArrayEx: NULL array\n");
+      return(-1);
+     }
+   if(arraysize<=0)
+     {
+      printf("SortStringArrayEx: wrong arraysize (%d)\n", arraysize);
+      return(-1);
+     }
+   if(threads<0)
+     {
+      printf("SortStringArrayEx: wrong threads number (%d)\n", threads);
+      return(-1);
+     }
+//---
+   SortStrings(arr,arraysize,(threads==0 ? SortDefaultThreads() : (threads>SORT_MAX_THREADS ? SORT_MAX_THREADS : threads)));
+//---
+   return(arraysize);
+  }
+//+------------------------------------------------------------------+
 //|                                                                  |
 //+------------------------------------------------------------------+
 MT4_EXPFUNC int __stdcall SortStringArray(MqlStr *arr,const int arraysize)
@@ -181,16 +652,19 @@ MT4_EXPFUNC int __stdcall SortStringArray(MqlStr *arr,const int arraysize)
       return(-1);
      }
 //---
-   qsort(arr,arraysize,sizeof(MqlStr),CompareMqlStr);
+   SortStrings(arr,arraysize,SortDefaultThreads());
 //---
    return(arraysize);
   }
 //+------------------------------------------------------------------+
-//|                                                                  |
+//| Appends arr[i+1] to arr[i] for every pair. Each string is        |
+//| measured once: the length of arr[i+1] measured in step i is the  |
+//| untouched length of the destination in step i+1. The copy goes   |
+//| straight to the known end offset instead of strcat rescanning.   |
 //+------------------------------------------------------------------+
 MT4_EXPFUNC int __stdcall ProcessStringArray(MqlStr *arr,const int arraysize)
   {
-   int   len1,len2;
+   size_t len1,len2;
 //---
    if(arr==NULL)
      {
@@ -203,13 +677,10 @@ MT4_EXPFUNC int __stdcall ProcessStringArray(MqlStr *arr,const int arraysize)
       return(-1);
      }
 //---
+   len2=(arr[0].string==NULL ? 0 : strlen(arr[0].string));
    for(int i=0; i<arraysize-1; i++)
      {
-      if(arr[i].string==NULL)
-         len1=0;
-      else
-         len1=strlen(arr[i].string);
-
+      len1=len2;
       if(arr[i+1].string==NULL)
          len2=0;
       else
@@ -221,27 +692,70 @@ MT4_EXPFUNC int __stdcall ProcessStringArray(MqlStr *arr,const int arraysize)
       if(arr[i].string==NULL)
          continue;
       //--- memory piece is less than needed and cannot be reallocated within dll
-      if(arr[i].len<len1+len2)
+      if(size_t(arr[i].len)<len1+len2)
          continue;
-      //--- final processing
-      strcat(arr[i].string,arr[i+1].string);
+      //--- final processing, terminating zero included
+      memcpy(arr[i].string+len1,arr[i+1].string,len2+1);
      }
 //---
    return(arraysize);
   }
 //+------------------------------------------------------------------+
-//|                                                                  |
+//| Chained concatenation of arr[1..arraysize-1] into arr[0], with   |
+//| an optional separator character (0 for none) between the parts.  |
+//| The write offset is tracked, so every source is read once and    |
+//| the total cost is linear in the output length.                   |
+//| Follows the MqlStr.len capacity rule of ProcessStringArray: the  |
+//| destination never grows beyond arr[0].len characters. When the   |
+//| next part does not fit, concatenation stops and the partial      |
+//| result stays zero-terminated. NULL sources are skipped.          |
+//| Returns the number of strings appended, or -1 on wrong arguments |
 //+------------------------------------------------------------------+
-int CompareMqlStr(const void *left,const void *right)
+MT4_EXPFUNC int __stdcall ConcatStringArray(MqlStr *arr,const int arraysize,const int separator)
   {
-   MqlStr *leftstr=(MqlStr *)left;
-   MqlStr *rightstr=(MqlStr *)right;
 //---
-   if(leftstr->string==NULL) 
+   if(arr==NULL)
+     {
+      printf("ConcatStringArray: NULL array\n");
+      return(-1);
+     }
+   if(arraysize<=0)
+     {
+      printf("ConcatStringArray: wrong arraysize (%d)\n", arraysize);
+      return(-1);
+     }
+   if(arr[0].string==NULL || arr[0].len<0)
+     {
+      printf("ConcatStringArray: destination string is uninitialized\n");
+      return(-1);
+     }
+   if(separator<0 || separator>255)
+     {
+      printf("ConcatStringArray: wrong separator (%d)\n", separator);
       return(-1);
-   if(rightstr->string==NULL) 
-      return(1);
+     }
+//---
+   char  *dst=arr[0].string;
+   size_t capacity=size_t(arr[0].len);
+   size_t offset=strlen(dst);
+   int    appended=0;
+   for(int i=1; i<arraysize; i++)
+     {
+      if(arr[i].string==NULL)
+         continue;
+      size_t len=strlen(arr[i].string);
+      //--- a separator precedes every part except the first one
+      size_t sep=(separator!=0 && offset>0 ? 1 : 0);
+      if(offset+sep+len>capacity)
+         break;
+      if(sep>0)
+         dst[offset++]=char(separator);
+      memcpy(dst+offset,arr[i].string,len);
+      offset+=len;
+      appended++;
+     }
+   dst[offset]=0;
 //---
-   return(strcmp(leftstr->string,rightstr->string));
+   return(appended);
   }
 //+------------------------------------------------------------------+
@@ -0,0 +1,324 @@
+//+------------------------------------------------------------------+
+//|                                Shared declarations for MQL4/MQL5 |
+//|                             Copyright 2000-2024, MetaQuotes Ltd. |
+//|                                               www.metaquotes.net |
+//+------------------------------------------------------------------+
+#ifndef DLLSAMPLE_H
+#define DLLSAMPLE_H
+//---
+#define MT4_EXPFUNC __declspec(dllexport)
+//+------------------------------------------------------------------+
+//| Terminal structures, byte-exact with the MQL side.               |
+//| The Win32 build serves MT4, the x64 build serves MT5, which is   |
+//| 64-bit only. MQL structures are passed with 1-byte packing.      |
+//+------------------------------------------------------------------+
+#pragma pack(push,1)
+#ifdef _WIN64
+//--- MT5 MqlRates: high comes before low, unlike the MT4 RateInfo
+struct RateInfo
+  {
+   __int64           ctm;
+   double            open;
+   double            high;
+   double            low;
+   double            close;
+   __int64           vol_tick;
+   int               spread;
+   __int64           vol_real;
+  };
+//--- MT5 MqlTick
+struct MqlTick
+  {
+   __int64           time;
+   double            bid;
+   double            ask;
+   double            last;
+   unsigned __int64  volume;
+   __int64           time_msc;
+   unsigned int      flags;
+   double            volume_real;
+  };
+#else
+struct RateInfo
+  {
+   __int64           ctm;
+   double            open;
+   double            low;
+   double            high;
+   double            close;
+   unsigned __int64  vol_tick;
+   int               spread;
+   unsigned __int64  vol_real;
+  };
+#endif
+#pragma pack(pop)
+//--- ABI id returned by GetLibraryInfo: RateInfo size, offset of 'high'
+//--- and pointer size. x64/MqlRates is 60|16|8, Win32/RateInfo 60|24|4,
+//--- so a build with the other field order is told apart by the offset.
+#define LIBRARY_ABI_ID(size,high_offset,pointer) ((size)|((high_offset)<<8)|((pointer)<<16))
+//--- MT4 string array element. MQL5 passes strings as 'const wchar_t *'
+//--- and cannot pass string arrays, so MqlStr exports are MT4 only.
+struct MqlStr
+  {
+   int               len;
+   char             *string;
+  };
+//+------------------------------------------------------------------+
+//| RateInfo field indices accepted by the rates exports             |
+//+------------------------------------------------------------------+
+#define RATE_TIME        0
+#define RATE_OPEN        1
+#define RATE_LOW         2
+#define RATE_HIGH        3
+#define RATE_CLOSE       4
+#define RATE_VOLUME      5
+#define RATE_MEDIAN      6     // (high+low)/2
+#define RATE_TYPICAL     7     // (high+low+close)/3
+#define RATE_WEIGHTED    8     // (high+low+2*close)/4
+#define RATE_TRUE_RANGE  9     // max(high,prev close)-min(low,prev close)
+#define RATE_LAST        RATE_TRUE_RANGE
+//+------------------------------------------------------------------+
+//| MqlTick field indices accepted by GetTicksSeries (MT5 only)      |
+//+------------------------------------------------------------------+
+#define TICK_TIME_MSC    0
+#define TICK_BID         1
+#define TICK_ASK         2
+#define TICK_LAST        3
+#define TICK_VOLUME      4     // volume_real
+#define TICK_SPREAD      5     // ask-bid
+#define TICK_MID         6     // (bid+ask)/2
+#define TICK_FIELD_LAST  TICK_MID
+//+------------------------------------------------------------------+
+//| Columnar bar cache file (written by GrandeBarCache.mqh)          |
+//| Layout: header, then bar_count values per column in the order    |
+//| time, open, high, low, close, volume. All columns are 8 bytes    |
+//| wide, so every column starts 8-byte aligned.                     |
+//+------------------------------------------------------------------+
+#define BARCACHE_MAGIC        0x31434247   // 'GBC1'
+#define BARCACHE_VERSION      1
+#define BARCACHE_SYMBOL_LEN   16
+#define BARCACHE_COLUMNS      6
+//---
+#pragma pack(push,1)
+struct BarCacheHeader
+  {
+   int               magic;
+   int               version;
+   int               header_size;
+   int               timeframe;
+   __int64           bar_count;
+   __int64           first_time;
+   __int64           last_time;
+   __int64           created;
+   char              symbol[BARCACHE_SYMBOL_LEN];
+  };
+#pragma pack(pop)
+//--- read-only column pointers into a mapped cache file
+struct BarCacheView
+  {
+   const BarCacheHeader *header;
+   const __int64    *time;
+   const double     *open;
+   const double     *high;
+   const double     *low;
+   const double     *close;
+   const __int64    *volume;
+   int               count;
+  };
+//--- used by other translation units to scan a cache without copying
+bool BarCacheGetView(const int handle,BarCacheView &view);
+//+------------------------------------------------------------------+
+//| Sentiment channel (DLLSentimentChannel.cpp): a named shared-     |
+//| memory ring written by the FinBERT services (sentiment_channel.  |
+//| py) and read by the EA. Layout: header, then slot_count records. |
+//| Record N (1-based publish sequence) lives in slot (N-1)%slots.   |
+//| Writers in any process hold the named mutex <name>Writer (e.g.   |
+//| "Local\GrandeSentimentChannelWriter") for the whole publish.     |
+//| The writer clears the record sequence, fills the body, stores    |
+//| the sequence, then the header sequence; a reader accepts a copy  |
+//| only if the record sequence matched before and after it.         |
+//+------------------------------------------------------------------+
+#define SENTIMENT_MAGIC           0x31435347   // 'GSC1'
+#define SENTIMENT_VERSION         1
+#define SENTIMENT_SLOTS           64
+#define SENTIMENT_SYMBOL_LEN      16
+#define SENTIMENT_REASONING_LEN   408          // UTF-8, NUL terminated
+#define SENTIMENT_WRITER_SUFFIX   L"Writer"    // appended to the mapping name
+#define SENTIMENT_WRITER_TIMEOUT  1000         // ms to wait for another writer
+//--- record kinds
+#define SENTIMENT_KIND_CALENDAR   1            // finbert_calendar_analyzer.py
+#define SENTIMENT_KIND_ENHANCED   2            // enhanced_finbert_analyzer.py
+//--- record flags
+#define SENTIMENT_FLAG_FALLBACK   1            // keyword fallback, not FinBERT
+//---
+#pragma pack(push,1)
+struct SentimentChannelHeader
+  {
+   int               magic;
+   int               version;
+   int               header_size;
+   int               record_size;
+   int               slot_count;
+   int               writer_pid;
+   __int64           sequence;          // last published record, 0 = none
+   __int64           heartbeat;         // writer unix time of the last publish
+   char              reserved[24];
+  };
+//--- 512 bytes
+struct SentimentRecord
+  {
+   __int64           sequence;
+   __int64           timestamp;         // unix time of the analysis
+   int               kind;              // SENTIMENT_KIND_*
+   int               signal;            // -2 STRONG_SELL .. 2 STRONG_BUY
+   double            score;
+   double            confidence;
+   double            surprise_accuracy;
+   double            signal_consistency;
+   double            processing_time_ms;
+   double            average_confidence;
+   int               event_count;
+   int               high_confidence_count;
+   int               flags;             // SENTIMENT_FLAG_*
+   int               reserved;
+   char              symbol[SENTIMENT_SYMBOL_LEN];
+   char              reasoning[SENTIMENT_REASONING_LEN];
+  };
+#pragma pack(pop)
+//+------------------------------------------------------------------+
+//| Grid-search optimizer (DLLOptimizer.cpp), byte-exact with the    |
+//| Native* structures in GrandeNativeLibrary.mqh                    |
+//+------------------------------------------------------------------+
+#define OPT_MODE_NET_PROFIT     0
+#define OPT_MODE_PROFIT_FACTOR  1
+#define OPT_MODE_SHARPE         2
+#define OPT_MODE_CUSTOM         3
+//---
+#pragma pack(push,1)
+struct OptimizerSettings
+  {
+   double            pip_value;
+   double            tick_value;
+   double            tick_size;
+   double            lot_step;
+   double            min_lot;
+   double            max_lot;
+   double            starting_balance;
+   double            min_trades;
+   double            min_win_rate;      // percent
+   double            prune_checkpoint;  // fraction of bars, 0 disables pruning
+   double            rsi_oversold;
+   double            rsi_overbought;
+   int               mode;              // OPT_MODE_*
+   int               first_bar;
+   int               rsi_period;
+   int               atr_period;
+   int               regime_period;
+  };
+//---
+struct OptimizerCombo
+  {
+   double            risk_trend;
+   double            risk_range;
+   double            risk_breakout;
+   double            sl_atr;
+   double            tp_ratio;
+  };
+//---
+struct OptimizerResult
+  {
+   int               total_trades;
+   int               winning_trades;
+   int               valid;
+   int               pruned;
+   double            win_rate;
+   double            net_profit;
+   double            gross_profit;
+   double            gross_loss;
+   double            profit_factor;
+   double            max_drawdown;
+   double            max_drawdown_percent;
+   double            avg_win;
+   double            avg_loss;
+   double            risk_reward;
+   double            expectancy;
+   double            sharpe_ratio;
+   double            custom_score;
+   double            final_balance;
+   double            peak_balance;
+  };
+#pragma pack(pop)
+//+------------------------------------------------------------------+
+//| Replay position simulator (DLLReplay.cpp), byte-exact with the   |
+//| NativeReplay* structures in GrandeNativeLibrary.mqh              |
+//+------------------------------------------------------------------+
+#define REPLAY_EXIT_NONE         0
+#define REPLAY_EXIT_STOP_LOSS    1
+#define REPLAY_EXIT_TAKE_PROFIT  2
+#define REPLAY_EXIT_MANUAL       3
+#define REPLAY_EXIT_END_OF_DATA  4
+//---
+#pragma pack(push,1)
+struct ReplaySettings
+  {
+   double            tick_value;
+   double            tick_size;
+   double            point;
+   double            spread;            // price units, when a bar carries none
+   double            stop_slippage;     // price units, against every stop fill
+   double            commission_per_lot;// per closed trade (round turn)
+   double            starting_balance;
+   int               capacity;          // open positions, preallocated
+   int               use_bar_spread;    // 1: RateInfo.spread (points) when > 0
+  };
+//---
+struct ReplayPosition
+  {
+   __int64           open_time;
+   double            entry;
+   double            stop_loss;
+   double            take_profit;
+   double            lots;
+   double            profit;            // marked at the last replayed quote
+   int               id;
+   int               is_buy;
+  };
+//---
+struct ReplayTrade
+  {
+   __int64           open_time;
+   __int64           close_time;
+   double            entry;
+   double            exit;
+   double            stop_loss;
+   double            take_profit;
+   double            lots;
+   double            profit;            // net of commission
+   int               id;
+   int               is_buy;
+   int               exit_reason;       // REPLAY_EXIT_*
+   int               reserved;
+  };
+//---
+struct ReplayStats
+  {
+   __int64           bars;
+   __int64           ticks;
+   double            balance;
+   double            equity;
+   double            peak_equity;
+   double            max_drawdown;
+   double            max_drawdown_percent;
+   double            gross_profit;
+   double            gross_loss;
+   double            commission;
+   int               open_positions;
+   int               total_trades;
+   int               winning_trades;
+   int               losing_trades;
+   int               rejected;          // opens refused with the pool full
+   int               reserved;
+  };
+#pragma pack(pop)
+//+------------------------------------------------------------------+
+#endif
@@ -0,0 +1,298 @@
+//+------------------------------------------------------------------+
+//|                            Shared-memory sentiment channel ring |
+//|                             Copyright 2000-2024, MetaQuotes Ltd. |
+//|                                               www.metaquotes.net |
+//+------------------------------------------------------------------+
+//| Hosts the named file mapping that the FinBERT services publish   |
+//| sentiment records into (layout in DLLSample.h). The EA checks    |
+//| SentimentChannelSequence on its timer and copies records out     |
+//| only when the sequence moved, so an unchanged channel costs one  |
+//| aligned 8-byte read and no file I/O or string parsing.           |
+//|                                                                  |
+//| Whichever side opens the channel first creates the mapping and   |
+//| initializes the header; it lives while any process holds it.     |
+//| SentimentChannelWrite is the native writer, used by MQL tools    |
+//| and tests; the Python services write the same layout directly.   |
+//| Every writer, in any process, publishes under the named writer   |
+//| mutex, so sequences are never claimed twice.                     |
+//|                                                                  |
+//| Exports return -1 on wrong arguments or an invalid handle.       |
+//+------------------------------------------------------------------+
+#include <windows.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "DLLSample.h"
+//---
+#define SENTIMENT_MAX_OPEN   8
+#define SENTIMENT_MAP_SIZE   (sizeof(SentimentChannelHeader)+SENTIMENT_SLOTS*sizeof(SentimentRecord))
+//+------------------------------------------------------------------+
+//| Open channel slot                                                |
+//+------------------------------------------------------------------+
+struct SentimentSlot
+  {
+   HANDLE                  mapping;
+   SentimentChannelHeader *header;
+   SentimentRecord        *records;
+   HANDLE                  writer;      // named cross-process writer mutex
+  };
+//--- handle N lives in ExtChannels[N-1]; a NULL header marks a free slot
+static SentimentSlot ExtChannels[SENTIMENT_MAX_OPEN];
+static SRWLOCK       ExtChannelsLock=SRWLOCK_INIT;
+//---
+static void SentimentRelease(SentimentSlot &slot)
+  {
+   if(slot.header!=NULL)
+      UnmapViewOfFile(slot.header);
+   if(slot.mapping!=NULL)
+      CloseHandle(slot.mapping);
+   if(slot.writer!=NULL)
+      CloseHandle(slot.writer);
+   memset(&slot,0,sizeof(slot));
+  }
+//---
+static bool SentimentGetSlot(const int handle,SentimentSlot &slot)
+  {
+   bool found=false;
+//---
+   AcquireSRWLockShared(&ExtChannelsLock);
+   if(handle>=1 && handle<=SENTIMENT_MAX_OPEN && ExtChannels[handle-1].header!=NULL)
+     {
+      slot=ExtChannels[handle-1];
+      found=true;
+     }
+   ReleaseSRWLockShared(&ExtChannelsLock);
+//---
+   return(found);
+  }
+//+------------------------------------------------------------------+
+//| Last published sequence. Volatile read, ordered before any       |
+//| record read that follows it.                                     |
+//+------------------------------------------------------------------+
+static __int64 SentimentLoadSequence(const volatile __int64 *sequence)
+  {
+   const __int64 value=*sequence;
+   MemoryBarrier();
+   return(value);
+  }
+//+------------------------------------------------------------------+
+//| Creates or opens the mapping 'name', e.g. the default            |
+//| "Local\GrandeSentimentChannel". Returns a handle or -1.          |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall SentimentChannelOpen(const wchar_t *name)
+  {
+//---
+   if(name==NULL || name[0]==L'\0')
+     {
+      printf("SentimentChannelOpen: empty name\n");
+      return(-1);
+     }
+//---
+   SentimentSlot slot;
+   memset(&slot,0,sizeof(slot));
+   slot.mapping=CreateFileMappingW(INVALID_HANDLE_VALUE,NULL,PAGE_READWRITE,0,DWORD(SENTIMENT_MAP_SIZE),name);
+   if(slot.mapping==NULL)
+     {
+      printf("SentimentChannelOpen: cannot create mapping (error %u)\n",(unsigned)GetLastError());
+      return(-1);
+     }
+   slot.header=(SentimentChannelHeader *)MapViewOfFile(slot.mapping,FILE_MAP_ALL_ACCESS,0,0,SENTIMENT_MAP_SIZE);
+   if(slot.header==NULL)
+     {
+      printf("SentimentChannelOpen: cannot map channel (error %u)\n",(unsigned)GetLastError());
+      SentimentRelease(slot);
+      return(-1);
+     }
+   slot.records=(SentimentRecord *)((char *)slot.header+sizeof(SentimentChannelHeader));
+//--- the Python services open the same mutex by name
+   wchar_t writer_name[MAX_PATH];
+   if(_snwprintf_s(writer_name,MAX_PATH,_TRUNCATE,L"%s%s",name,SENTIMENT_WRITER_SUFFIX)<0 ||
+      (slot.writer=CreateMutexW(NULL,FALSE,writer_name))==NULL)
+     {
+      printf("SentimentChannelOpen: cannot create writer mutex (error %u)\n",(unsigned)GetLastError());
+      SentimentRelease(slot);
+      return(-1);
+     }
+//--- a fresh mapping is zero filled; the first opener writes the header
+   SentimentChannelHeader *header=slot.header;
+   if(header->magic==0)
+     {
+      header->version    =SENTIMENT_VERSION;
+      header->header_size=int(sizeof(SentimentChannelHeader));
+      header->record_size=int(sizeof(SentimentRecord));
+      header->slot_count =SENTIMENT_SLOTS;
+      MemoryBarrier();
+      header->magic=SENTIMENT_MAGIC;
+     }
+   if(header->magic!=SENTIMENT_MAGIC || header->version!=SENTIMENT_VERSION ||
+      header->header_size!=int(sizeof(SentimentChannelHeader)) ||
+      header->record_size!=int(sizeof(SentimentRecord)) || header->slot_count!=SENTIMENT_SLOTS)
+     {
+      printf("SentimentChannelOpen: incompatible channel layout (version %d)\n",header->version);
+      SentimentRelease(slot);
+      return(-1);
+     }
+//---
+   int handle=-1;
+   AcquireSRWLockExclusive(&ExtChannelsLock);
+   for(int i=0; i<SENTIMENT_MAX_OPEN; i++)
+     {
+      if(ExtChannels[i].header==NULL)
+        {
+         ExtChannels[i]=slot;
+         handle=i+1;
+         break;
+        }
+     }
+   ReleaseSRWLockExclusive(&ExtChannelsLock);
+//---
+   if(handle<0)
+     {
+      printf("SentimentChannelOpen: too many open channels (%d)\n",SENTIMENT_MAX_OPEN);
+      SentimentRelease(slot);
+     }
+   return(handle);
+  }
+//+------------------------------------------------------------------+
+//| Unmaps a channel. Returns 1, or -1 for an unknown handle.        |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall SentimentChannelClose(const int handle)
+  {
+   int result=-1;
+//---
+   AcquireSRWLockExclusive(&ExtChannelsLock);
+   if(handle>=1 && handle<=SENTIMENT_MAX_OPEN && ExtChannels[handle-1].header!=NULL)
+     {
+      SentimentRelease(ExtChannels[handle-1]);
+      result=1;
+     }
+   ReleaseSRWLockExclusive(&ExtChannelsLock);
+//---
+   return(result);
+  }
+//+------------------------------------------------------------------+
+//| Last published sequence (0 before the first record).             |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC __int64 __stdcall SentimentChannelSequence(const int handle)
+  {
+   SentimentSlot slot;
+//---
+   if(!SentimentGetSlot(handle,slot))
+     {
+      printf("SentimentChannelSequence: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+//---
+   return(SentimentLoadSequence(&slot.header->sequence));
+  }
+//+------------------------------------------------------------------+
+//| Channel summary: info[0]=sequence, [1]=heartbeat, [2]=writer     |
+//| pid, [3]=slot count. Returns the slot count.                     |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall SentimentChannelInfo(const int handle,__int64 *info,const int info_size)
+  {
+   SentimentSlot slot;
+//---
+   if(!SentimentGetSlot(handle,slot))
+     {
+      printf("SentimentChannelInfo: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   if(info!=NULL)
+     {
+      const SentimentChannelHeader *header=slot.header;
+      const __int64 values[4]={ SentimentLoadSequence(&header->sequence),header->heartbeat,
+                                header->writer_pid,header->slot_count };
+      for(int i=0; i<info_size && i<4; i++)
+         info[i]=values[i];
+     }
+//---
+   return(slot.header->slot_count);
+  }
+//+------------------------------------------------------------------+
+//| Copies record 'sequence' into 'record'. Returns 1, or 0 when it  |
+//| is not published yet, already overwritten or being rewritten.   |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall SentimentChannelRead(const int handle,const __int64 sequence,SentimentRecord *record)
+  {
+   SentimentSlot slot;
+//---
+   if(!SentimentGetSlot(handle,slot))
+     {
+      printf("SentimentChannelRead: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   if(record==NULL || sequence<1)
+     {
+      printf("SentimentChannelRead: wrong arguments (sequence %I64d)\n",sequence);
+      return(-1);
+     }
+   const __int64 last=SentimentLoadSequence(&slot.header->sequence);
+   if(sequence>last || last-sequence>=SENTIMENT_SLOTS)
+      return(0);
+//--- the record sequence brackets the copy: a writer reusing the slot
+//--- clears it first, so a torn copy never matches on both reads
+   const SentimentRecord *src=&slot.records[(sequence-1)%SENTIMENT_SLOTS];
+   if(SentimentLoadSequence(&src->sequence)!=sequence)
+      return(0);
+   memcpy(record,src,sizeof(SentimentRecord));
+   MemoryBarrier();
+   if(SentimentLoadSequence(&src->sequence)!=sequence)
+      return(0);
+   record->sequence=sequence;
+   record->symbol[SENTIMENT_SYMBOL_LEN-1]='\0';
+   record->reasoning[SENTIMENT_REASONING_LEN-1]='\0';
+//---
+   return(1);
+  }
+//+------------------------------------------------------------------+
+//| Publishes 'record' as the next sequence and stores that sequence |
+//| back into record->sequence. Returns 1, or 0 when another writer  |
+//| held the channel longer than SENTIMENT_WRITER_TIMEOUT.           |
+//+------------------------------------------------------------------+
+MT4_EXPFUNC int __stdcall SentimentChannelWrite(const int handle,SentimentRecord *record)
+  {
+   SentimentSlot slot;
+//---
+   if(!SentimentGetSlot(handle,slot))
+     {
+      printf("SentimentChannelWrite: invalid handle (%d)\n",handle);
+      return(-1);
+     }
+   if(record==NULL)
+     {
+      printf("SentimentChannelWrite: wrong arguments\n");
+      return(-1);
+     }
+//---
+//--- an abandoned mutex left at most an invalidated slot that was never
+//--- published, so the next sequence simply rewrites it
+   const DWORD wait=WaitForSingleObject(slot.writer,SENTIMENT_WRITER_TIMEOUT);
+   if(wait!=WAIT_OBJECT_0 && wait!=WAIT_ABANDONED)
+     {
+      printf("SentimentChannelWrite: writer mutex busy (wait %u)\n",(unsigned)wait);
+      return(0);
+     }
+   SentimentChannelHeader *header=slot.header;
+   const __int64 sequence=header->sequence+1;
+   SentimentRecord *dst=&slot.records[(sequence-1)%SENTIMENT_SLOTS];
+//--- invalidate, fill the body, then publish record and header sequence
+   dst->sequence=0;
+   MemoryBarrier();
+   memcpy((char *)dst+sizeof(dst->sequence),(const char *)record+sizeof(record->sequence),
+          sizeof(SentimentRecord)-sizeof(record->sequence));
+   dst->symbol[SENTIMENT_SYMBOL_LEN-1]='\0';
+   dst->reasoning[SENTIMENT_REASONING_LEN-1]='\0';
+   MemoryBarrier();
+   dst->sequence=sequence;
+   header->writer_pid=int(GetCurrentProcessId());
+   header->heartbeat =(__int64)time(NULL);
+   MemoryBarrier();
+   header->sequence=sequence;
+   ReleaseMutex(slot.writer);
+//---
+   record->sequence=sequence;
+   return(1);
+  }
+//+------------------------------------------------------------------+
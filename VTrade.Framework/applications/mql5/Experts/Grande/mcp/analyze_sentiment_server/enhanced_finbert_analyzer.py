@@ -24,6 +24,11 @@ from typing import Any, Dict, List, Optional, Tuple
 import numpy as np
 import sys
 
+try:
+    from sentiment_channel import publish_result, KIND_ENHANCED
+except ImportError:
+    publish_result = None
+
 # Fix Windows encoding issues with Unicode characters
 if sys.platform == "win32":
     import codecs
@@ -1087,6 +1092,10 @@ def main(argv: Optional[List[str]] = None) -> int:
     with open(output_path, "w", encoding="utf-8") as f:
         json.dump(result, f, indent=2)
     
+    # Shared-memory copy for the EA; the JSON file stays the fallback
+    if publish_result is not None:
+        publish_result(result, KIND_ENHANCED)
+    
     print(f"Enhanced FinBERT analysis completed: {result['signal']} (confidence: {result['confidence']:.3f})")
     print(f"Output saved to: {output_path}")
     
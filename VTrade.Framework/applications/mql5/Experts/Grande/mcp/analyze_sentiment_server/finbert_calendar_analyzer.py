@@ -16,6 +16,7 @@ FinBERT-only Economic Calendar Analyzer
   a final signal of: STRONG_BUY, BUY, NEUTRAL, SELL, STRONG_SELL.
 
 - Writes result to Common\Files\integrated_calendar_analysis.json
+- Publishes it to the shared-memory sentiment channel (sentiment_channel.py)
 
 CLI:
   python finbert_calendar_analyzer.py \
@@ -35,6 +36,11 @@ import sys
 from dataclasses import dataclass
 from typing import Any, Dict, List, Optional, Tuple
 
+try:
+    from sentiment_channel import publish_result, KIND_CALENDAR
+except ImportError:
+    publish_result = None
+
 # Fix Windows encoding issues with Unicode characters
 if sys.platform == "win32":
     import codecs
@@ -682,6 +688,9 @@ def main(argv: Optional[List[str]] = None) -> int:
     result["timestamp"] = datetime.now().isoformat()
     outp = write_result(result, args.output_path)
     print(outp)
+    # Shared-memory copy for the EA; the JSON file stays the fallback
+    if publish_result is not None:
+        publish_result(result, KIND_CALENDAR)
     return 0
 
 
@@ -10,6 +10,8 @@ Purpose:
 - Automatically run enhanced_finbert_analyzer.py when new files arrive
 - Process files in order (oldest first)
 - Maintain a processed files log to avoid duplicates
+- Publish each result to the shared-memory sentiment channel, so the EA
+  picks it up within one timer slice (JSON output is kept as the fallback)
 - Run as a background service
 
 Usage:
@@ -49,6 +51,12 @@ except ImportError as e:
     print(f"WARNING: Could not import enhanced_finbert_analyzer: {e}")
     ANALYZER_AVAILABLE = False
 
+try:
+    from sentiment_channel import publish_result, get_channel, KIND_ENHANCED
+    CHANNEL_AVAILABLE = True
+except ImportError:
+    CHANNEL_AVAILABLE = False
+
 
 # ----------------------------- Configuration ---------------------------------
 
@@ -167,6 +175,11 @@ def process_market_context_file(filepath: str) -> bool:
                    f"processing time: {result['processing_time_ms']:.1f}ms)")
         logger.info(f"Output saved to: {output_path}")
         
+        if CHANNEL_AVAILABLE:
+            sequence = publish_result(result, KIND_ENHANCED)
+            if sequence:
+                logger.info(f"Published to sentiment channel (sequence {sequence})")
+        
         return True
         
     except Exception as e:
@@ -218,6 +231,7 @@ def run_watcher_service():
     logger.info(f"Log file: {LOG_FILE}")
     logger.info(f"Processed files log: {PROCESSED_FILES_LOG}")
     logger.info(f"Analyzer available: {ANALYZER_AVAILABLE}")
+    logger.info(f"Sentiment channel: {'open' if CHANNEL_AVAILABLE and get_channel() else 'unavailable (JSON only)'}")
     
     if not ANALYZER_AVAILABLE:
         logger.error("Cannot start service: Enhanced FinBERT analyzer not available")
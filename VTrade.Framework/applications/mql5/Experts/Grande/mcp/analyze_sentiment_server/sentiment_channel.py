@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+"""
+Shared-memory sentiment channel writer for the Grande Trading System
+
+Publishes FinBERT calendar and enhanced analysis results into the named
+shared-memory ring that the EA reads through DLLSample
+(DLLSentimentChannel.cpp, layout in DLLSample.h). The EA checks a single
+sequence number on its timer and copies records only when it moved, so a
+result reaches the EA within one timer slice instead of on the next JSON
+file poll.
+
+Layout (little endian, must match DLLSample.h):
+- 64-byte header: magic, version, header_size, record_size, slot_count,
+  writer_pid, sequence, heartbeat
+- SLOT_COUNT records of 512 bytes; record N lives in slot (N-1) % SLOT_COUNT
+
+Publish protocol: hold the named mutex "<channel>Writer" (shared with the
+DLL and every other service process), clear the record sequence, write the
+body, store the record sequence, then the header sequence.
+
+Windows only (named mappings). Elsewhere the channel reports itself as
+unavailable and callers keep writing the JSON files, which stay the
+fallback on every platform.
+
+Usage:
+    from sentiment_channel import publish_result
+    publish_result(result, KIND_CALENDAR)
+"""
+
+import os
+import sys
+import mmap
+import time
+import struct
+import ctypes
+from typing import Any, Dict, Optional
+
+
+# ----------------------------- Layout ----------------------------------------
+
+CHANNEL_NAME = os.environ.get("GRANDE_SENTIMENT_CHANNEL", "Local\\GrandeSentimentChannel")
+WRITER_SUFFIX = "Writer"    # named writer mutex: CHANNEL_NAME + WRITER_SUFFIX
+WRITER_TIMEOUT_MS = 1000
+
+MAGIC = 0x31435347          # 'GSC1'
+VERSION = 1
+SLOT_COUNT = 64
+SYMBOL_LEN = 16
+REASONING_LEN = 408
+
+KIND_CALENDAR = 1
+KIND_ENHANCED = 2
+
+FLAG_FALLBACK = 1
+
+HEADER = struct.Struct("<6iqq24x")
+RECORD_BODY = struct.Struct("<q2i6d4i16s408s")      # everything after 'sequence'
+SEQUENCE = struct.Struct("<q")
+RECORD_SIZE = SEQUENCE.size + RECORD_BODY.size
+
+HEADER_SEQUENCE_OFFSET = 24
+MAP_SIZE = HEADER.size + SLOT_COUNT * RECORD_SIZE
+
+SIGNAL_CODES = {"STRONG_SELL": -2, "SELL": -1, "NEUTRAL": 0, "BUY": 1, "STRONG_BUY": 2}
+
+assert HEADER.size == 64 and RECORD_SIZE == 512
+
+
+# ----------------------------- Channel ---------------------------------------
+
+class SentimentChannel:
+    """Writer side of the shared-memory ring"""
+
+    def __init__(self, name: str = CHANNEL_NAME):
+        self.name = name
+        self._map: Optional[mmap.mmap] = None
+        self._writer = None
+
+    def open(self) -> bool:
+        if self._map is not None:
+            return True
+        if sys.platform != "win32":
+            return False
+        self._writer = _WriterMutex.create(self.name + WRITER_SUFFIX)
+        if self._writer is None:
+            return False
+        try:
+            # Creates the mapping, or opens the one the EA created
+            self._map = mmap.mmap(-1, MAP_SIZE, tagname=self.name)
+        except OSError:
+            self.close()
+            return False
+
+        magic, version, header_size, record_size, slot_count, _, _, _ = HEADER.unpack_from(self._map, 0)
+        if magic == 0:
+            HEADER.pack_into(self._map, 0, 0, VERSION, HEADER.size, RECORD_SIZE, SLOT_COUNT, 0, 0, 0)
+            struct.pack_into("<i", self._map, 0, MAGIC)
+        elif (magic, version, header_size, record_size, slot_count) != (MAGIC, VERSION, HEADER.size, RECORD_SIZE, SLOT_COUNT):
+            self.close()
+            return False
+        return True
+
+    def close(self):
+        if self._map is not None:
+            self._map.close()
+            self._map = None
+        if self._writer is not None:
+            self._writer.close()
+            self._writer = None
+
+    def sequence(self) -> int:
+        if self._map is None:
+            return 0
+        return SEQUENCE.unpack_from(self._map, HEADER_SEQUENCE_OFFSET)[0]
+
+    def publish(self, kind: int, signal: str, score: float, confidence: float, reasoning: str,
+                event_count: int = 0, surprise_accuracy: float = 0.0, signal_consistency: float = 0.0,
+                processing_time_ms: float = 0.0, high_confidence_count: int = 0,
+                average_confidence: float = 0.0, symbol: str = "", fallback: bool = False,
+                timestamp: Optional[float] = None) -> int:
+        """Append one record; returns its sequence, or 0 when closed or another writer is stuck"""
+        if self._map is None:
+            return 0
+
+        now = int(time.time())
+        body = RECORD_BODY.pack(
+            int(timestamp if timestamp is not None else now),
+            kind,
+            SIGNAL_CODES.get(str(signal).upper(), 0),
+            float(score), float(confidence),
+            float(surprise_accuracy), float(signal_consistency),
+            float(processing_time_ms), float(average_confidence),
+            int(event_count), int(high_confidence_count),
+            FLAG_FALLBACK if fallback else 0, 0,
+            _text(symbol, SYMBOL_LEN),
+            _text(reasoning, REASONING_LEN),
+        )
+
+        # Read-and-advance of the sequence must not interleave with the
+        # DLL or another service process publishing to the same channel
+        if not self._writer.acquire(WRITER_TIMEOUT_MS):
+            print("Sentiment channel publish skipped: writer mutex busy")
+            return 0
+        try:
+            seq = self.sequence() + 1
+            offset = HEADER.size + ((seq - 1) % SLOT_COUNT) * RECORD_SIZE
+            SEQUENCE.pack_into(self._map, offset, 0)
+            self._map[offset + SEQUENCE.size:offset + RECORD_SIZE] = body
+            SEQUENCE.pack_into(self._map, offset, seq)
+            struct.pack_into("<i", self._map, 20, os.getpid())
+            struct.pack_into("<q", self._map, HEADER_SEQUENCE_OFFSET + 8, now)
+            SEQUENCE.pack_into(self._map, HEADER_SEQUENCE_OFFSET, seq)
+        finally:
+            self._writer.release()
+        return seq
+
+
+class _WriterMutex:
+    """Named Win32 mutex shared with DLLSentimentChannel.cpp and other writer processes"""
+
+    WAIT_OBJECT_0 = 0x00000000
+    WAIT_ABANDONED = 0x00000080
+
+    def __init__(self, kernel32, handle):
+        self._kernel32 = kernel32
+        self._handle = handle
+
+    @classmethod
+    def create(cls, name: str) -> Optional["_WriterMutex"]:
+        try:
+            kernel32 = ctypes.WinDLL("kernel32", use_last_error=True)
+            kernel32.CreateMutexW.restype = ctypes.c_void_p
+            kernel32.CreateMutexW.argtypes = (ctypes.c_void_p, ctypes.c_int, ctypes.c_wchar_p)
+            kernel32.WaitForSingleObject.restype = ctypes.c_uint32
+            kernel32.WaitForSingleObject.argtypes = (ctypes.c_void_p, ctypes.c_uint32)
+            kernel32.ReleaseMutex.argtypes = (ctypes.c_void_p,)
+            kernel32.CloseHandle.argtypes = (ctypes.c_void_p,)
+        except (AttributeError, OSError):
+            return None
+        handle = kernel32.CreateMutexW(None, 0, name)
+        return cls(kernel32, handle) if handle else None
+
+    def acquire(self, timeout_ms: int) -> bool:
+        # An abandoned mutex left at most an unpublished slot; the next sequence rewrites it
+        result = self._kernel32.WaitForSingleObject(self._handle, timeout_ms)
+        return result in (self.WAIT_OBJECT_0, self.WAIT_ABANDONED)
+
+    def release(self):
+        self._kernel32.ReleaseMutex(self._handle)
+
+    def close(self):
+        if self._handle:
+            self._kernel32.CloseHandle(self._handle)
+            self._handle = None
+
+
+def _text(value: Any, size: int) -> bytes:
+    """NUL-terminated UTF-8 that fits the field without splitting a character"""
+    data = str(value or "").encode("utf-8")[:size - 1]
+    return data.decode("utf-8", "ignore").encode("utf-8")
+
+
+# ----------------------------- Result Mapping --------------------------------
+
+_CHANNEL: Optional[SentimentChannel] = None
+
+
+def get_channel() -> Optional[SentimentChannel]:
+    """Process-wide channel, opened on first use; None when unavailable"""
+    global _CHANNEL
+    if _CHANNEL is None:
+        _CHANNEL = SentimentChannel()
+    return _CHANNEL if _CHANNEL.open() else None
+
+
+def publish_result(result: Dict[str, Any], kind: int) -> int:
+    """
+    Publish an analyzer result dict (the same one written to JSON).
+
+    Calendar results carry the research metrics; enhanced results carry
+    the multi-modal scores, folded into the reasoning the same way the
+    EA's JSON parser does. Returns the sequence, or 0 if not published.
+    """
+    channel = get_channel()
+    if channel is None:
+        return 0
+
+    fallback = result.get("finbert_status") == "FALLBACK_MODE" or "FALLBACK" in str(result.get("reasoning", ""))
+    try:
+        if kind == KIND_ENHANCED:
+            reasoning = str(result.get("reasoning", ""))
+            if result.get("risk_level"):
+                reasoning += f" | Risk: {result['risk_level']}"
+            for label, key in (("Tech", "technical_score"), ("Regime", "regime_score"),
+                               ("Econ", "economic_score"), ("Size", "position_size_multiplier")):
+                if key in result:
+                    reasoning += f" | {label}: {float(result[key]):.2f}"
+            return channel.publish(
+                KIND_ENHANCED, result.get("signal", "NEUTRAL"),
+                result.get("weighted_score", 0.0), result.get("confidence", 0.0), reasoning,
+                event_count=1,
+                signal_consistency=result.get("confluence_score", 0.0),
+                processing_time_ms=result.get("processing_time_ms", 0.0),
+                symbol=result.get("symbol", ""), fallback=fallback)
+
+        metrics = result.get("metrics", {}) or {}
+        return channel.publish(
+            KIND_CALENDAR, result.get("signal", "NEUTRAL"),
+            result.get("score", 0.0), result.get("confidence", 0.0), result.get("reasoning", ""),
+            event_count=result.get("event_count", 0),
+            surprise_accuracy=metrics.get("surprise_accuracy", 0.0),
+            signal_consistency=metrics.get("signal_consistency", 0.0),
+            processing_time_ms=metrics.get("processing_time_ms", 0.0),
+            high_confidence_count=metrics.get("high_confidence_predictions", 0),
+            average_confidence=metrics.get("average_confidence", 0.0),
+            fallback=fallback)
+    except (TypeError, ValueError, struct.error) as e:
+        print(f"Sentiment channel publish failed: {e}")
+        return 0
@@ -193,13 +193,14 @@ ORDER BY prob_range;
 
 # 3. Market Data (for backtesting)
 if ($dataSummary["market_data"] -gt 0) {
+    # market_data.timestamp is epoch seconds (schema v2); format it in SQL
     $marketQuery = @"
 SELECT 
     COUNT(*) as total,
     COUNT(DISTINCT symbol) as symbols,
     COUNT(DISTINCT timeframe) as timeframes,
-    MIN(timestamp) as first_bar,
-    MAX(timestamp) as last_bar
+    datetime(MIN(timestamp), 'unixepoch') as first_bar,
+    datetime(MAX(timestamp), 'unixepoch') as last_bar
 FROM market_data;
 "@
     $marketData = Invoke-SqliteQuery -DataSource $DatabasePath -Query $marketQuery
@@ -226,8 +227,8 @@ SELECT
     symbol,
     timeframe,
     COUNT(*) as bars,
-    MIN(timestamp) as first_bar,
-    MAX(timestamp) as last_bar
+    datetime(MIN(timestamp), 'unixepoch') as first_bar,
+    datetime(MAX(timestamp), 'unixepoch') as last_bar
 FROM market_data
 GROUP BY symbol, timeframe
 ORDER BY symbol, timeframe;
@@ -235,19 +235,20 @@ CREATE TABLE IF NOT EXISTS limit_orders (
 }
 
 # Create market_data table (if missing)
+# Must match CGrandeDatabaseManager::CreateMarketDataTable (schema v2): epoch-second
+# timestamps, clustered (symbol, timeframe, timestamp) key, WITHOUT ROWID
 if ($tablesToCreate -contains "market_data") {
     Write-Host "Creating market_data table..." -ForegroundColor Gray
     Invoke-SqliteQuery -DataSource $DatabasePath -Query @"
 CREATE TABLE IF NOT EXISTS market_data (
-    id INTEGER PRIMARY KEY AUTOINCREMENT,
     symbol TEXT NOT NULL,
     timeframe INTEGER NOT NULL,
-    timestamp DATETIME NOT NULL,
+    timestamp INTEGER NOT NULL,
     open_price REAL NOT NULL,
     high_price REAL NOT NULL,
     low_price REAL NOT NULL,
     close_price REAL NOT NULL,
-    volume REAL,
+    volume INTEGER,
     atr REAL,
     adx_h1 REAL,
     adx_h4 REAL,
@@ -260,14 +261,16 @@ CREATE TABLE IF NOT EXISTS market_data (
     ema_200 REAL,
     stoch_k REAL,
     stoch_d REAL,
-    created_at DATETIME DEFAULT CURRENT_TIMESTAMP
-);
+    created_at INTEGER DEFAULT (CAST(strftime('%s', 'now') AS INTEGER)),
+    PRIMARY KEY (symbol, timeframe, timestamp)
+) WITHOUT ROWID;
 "@ | Out-Null
     
-    # Create indexes
+    # Same index set as CreateIndexes(); the primary key covers (symbol, timeframe, timestamp)
     Invoke-SqliteQuery -DataSource $DatabasePath -Query "CREATE INDEX IF NOT EXISTS idx_market_data_symbol_time ON market_data(symbol, timestamp);" | Out-Null
-    Invoke-SqliteQuery -DataSource $DatabasePath -Query "CREATE INDEX IF NOT EXISTS idx_market_data_timeframe ON market_data(timeframe);" | Out-Null
-    Write-Host "  ✅ market_data table created with indexes" -ForegroundColor Green
+    # Mark the table as v2 so the EA does not try to migrate it from v1 text timestamps
+    Invoke-SqliteQuery -DataSource $DatabasePath -Query "PRAGMA user_version = 2;" | Out-Null
+    Write-Host "  ✅ market_data table created (schema v2)" -ForegroundColor Green
 }
 
 # Create market_regimes table
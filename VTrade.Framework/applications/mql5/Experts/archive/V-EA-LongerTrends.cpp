@@ -8,6 +8,11 @@
 #property version   "1.00"
 
 #include <Trade\Trade.mqh>
+#include "../Grande/Include/GrandeIncrementalIndicators.mqh"
+#include "../Grande/Include/GrandeIndicatorHandles.mqh"
+#include "../Grande/Include/GrandeLogger.mqh"
+#include "../Grande/Include/GrandeProfiler.mqh"
+#include "../Grande/Include/GrandeRulePipeline.mqh"
 
 //--- Input parameters
 input double   InpLotSize         = 0.1;    // Lot size
@@ -25,30 +30,190 @@ input int      InpTrendExitPeriod  = 100;    // Trend EMA period for exit confir
 input double   InpATRMultiplier    = 3.0;    // ATR multiplier for trailing stop
 input int      InpATRPeriod        = 14;     // ATR period
 input int      InpMinHoldDuration  = 60;     // Minimum holding duration in minutes
+input int      InpIndicatorSeedBars= 1000;   // H1 bars used to seed indicator state
+input GRANDE_LOG_LEVEL InpLogLevel  = GRANDE_LOG_INFO; // Minimum log level (DEBUG logs indicator values)
+input int      InpLogRatePerMinute = 6;      // Max repeats of one message per minute (0 = no limit)
+input bool     InpUseTrendFilter   = true;   // Require H1 EMA slope in the entry direction
+input bool     InpUseRSIExit       = true;   // Exit on D1 RSI crossing the exit level
+input bool     InpUseTrendExit     = true;   // Exit on D1 EMA crossing the exit EMA
+input bool     InpUseATRTrailing   = true;   // Trail the stop by ATR
+input bool     InpProfileDecisions = false;  // Time the per-bar decision (report on deinit)
 
 //--- Global variables
-int            trendHandle;
-int            rsiHandle;
-int            macdHandle;
-int            atrHandle;
+CGrandeIndicatorState h1State;          // H1 EMA/RSI/MACD/ATR, updated in O(1) per tick
+CGrandeIndicatorHandles handles;        // D1 exit handles, created once
+int            trendHandleHigher;
+int            rsiHandleHigher;
+int            trendExitHandle;
+double         trendValueHigher[];      // D1 exit reads, reserved once in OnInit
+double         rsiValueHigher[];
+CGrandeLogger  logger;                  // Buffered, flushed from OnTimer
 CTrade         trade;
+CGrandeProfiler profiler;
+int            decisionSection = -1;
+
+//+------------------------------------------------------------------+
+//| Decision context: values shared by every rule for one bar        |
+//+------------------------------------------------------------------+
+class CTrendContext
+{
+public:
+   double bid;
+   double ask;
+   double atr;
+   double trend[3];                    // H1 EMA, index 0 = forming bar
+   double rsi[3];
+   double exitTrend;                   // D1 exit EMA, valid after LoadD1()
+   
+   CTrendContext() { bid = ask = atr = exitTrend = 0; Reset(); }
+   
+   void Reset() { m_d1Tried = false; m_d1Ready = false; }
+   
+   // D1 buffers are copied at most once per bar, and only if a D1 rule runs
+   bool LoadD1()
+   {
+      if(m_d1Tried)
+         return m_d1Ready;
+      m_d1Tried = true;
+      
+      if(handles.Copy(trendHandleHigher, 0, 0, 3, trendValueHigher) < 3 ||
+         handles.Copy(rsiHandleHigher, 0, 0, 3, rsiValueHigher) < 3)
+         return false;
+      
+      // Slower D1 EMA used to confirm trend exits
+      exitTrend = handles.Value(trendExitHandle, 0, 0);
+      if(exitTrend == EMPTY_VALUE)
+         return false;
+      
+      if(logger.IsEnabled(GRANDE_LOG_DEBUG)) {
+         logger.Debug("D1", StringFormat("EMA %.5f, %.5f, %.5f | RSI %.2f, %.2f, %.2f | Exit EMA %.5f",
+                            trendValueHigher[0], trendValueHigher[1], trendValueHigher[2],
+                            rsiValueHigher[0], rsiValueHigher[1], rsiValueHigher[2],
+                            exitTrend));
+      }
+      m_d1Ready = true;
+      return true;
+   }
+   
+private:
+   bool m_d1Tried;
+   bool m_d1Ready;
+};
+
+//+------------------------------------------------------------------+
+//| Rules                                                            |
+//+------------------------------------------------------------------+
+// H1 EMA rising (long) or falling (short)
+class CTrendSlopeRule : public CGrandeRule<CTrendContext>
+{
+private:
+   bool m_up;
+public:
+   CTrendSlopeRule(bool up) { m_up = up; }
+   virtual bool Evaluate(CTrendContext &ctx)
+   {
+      return m_up ? ctx.trend[0] > ctx.trend[1] : ctx.trend[0] < ctx.trend[1];
+   }
+   virtual string Name() const { return m_up ? "H1TrendUp" : "H1TrendDown"; }
+};
+
+// H1 RSI crossing a level upwards (long) or downwards (short)
+class CRSICrossRule : public CGrandeRule<CTrendContext>
+{
+private:
+   double m_level;
+   bool   m_up;
+public:
+   CRSICrossRule(double level, bool up) { m_level = level; m_up = up; }
+   virtual bool Evaluate(CTrendContext &ctx)
+   {
+      return m_up ? ctx.rsi[0] > m_level && ctx.rsi[1] <= m_level
+                  : ctx.rsi[0] < m_level && ctx.rsi[1] >= m_level;
+   }
+   virtual string Name() const { return m_up ? "H1RSICrossUp" : "H1RSICrossDown"; }
+};
+
+// D1 RSI crossing the exit level
+class CD1RSIExitRule : public CGrandeRule<CTrendContext>
+{
+private:
+   double m_level;
+   bool   m_up;
+public:
+   CD1RSIExitRule(double level, bool up) { m_level = level; m_up = up; }
+   virtual bool Evaluate(CTrendContext &ctx)
+   {
+      if(!ctx.LoadD1())
+         return false;
+      return m_up ? rsiValueHigher[0] > m_level && rsiValueHigher[1] <= m_level
+                  : rsiValueHigher[0] < m_level && rsiValueHigher[1] >= m_level;
+   }
+   virtual int Cost() const { return 10; }
+   virtual string Name() const { return "D1RSIExit"; }
+};
+
+// D1 EMA crossing below (long exit) or above (short exit) the slower exit EMA
+class CD1TrendExitRule : public CGrandeRule<CTrendContext>
+{
+private:
+   bool m_long;
+public:
+   CD1TrendExitRule(bool longSide) { m_long = longSide; }
+   virtual bool Evaluate(CTrendContext &ctx)
+   {
+      if(!ctx.LoadD1())
+         return false;
+      return m_long ? trendValueHigher[1] > ctx.exitTrend && trendValueHigher[0] < ctx.exitTrend
+                    : trendValueHigher[1] < ctx.exitTrend && trendValueHigher[0] > ctx.exitTrend;
+   }
+   virtual int Cost() const { return 11; }
+   virtual string Name() const { return "D1TrendExit"; }
+};
+
+// Chains composed once in OnInit from the enabled features
+CTrendContext                        ctx;
+CGrandeRulePipeline<CTrendContext>  *longEntry;
+CGrandeRulePipeline<CTrendContext>  *shortEntry;
+CGrandeRulePipeline<CTrendContext>  *longExit;
+CGrandeRulePipeline<CTrendContext>  *shortExit;
+bool                                 useTrailing;
 
 //+------------------------------------------------------------------+
 //| Expert initialization function                                   |
 //+------------------------------------------------------------------+
 int OnInit()
 {
-   // Create handles for indicators
-   trendHandle = iMA(_Symbol, PERIOD_H1, InpTrendPeriod, 0, MODE_EMA, PRICE_CLOSE);
-   rsiHandle   = iRSI(_Symbol, PERIOD_H1, InpRSIPeriod, PRICE_CLOSE);
-   macdHandle  = iMACD(_Symbol, PERIOD_H1, InpMACDFastPeriod, InpMACDSlowPeriod, InpMACDSignalPeriod, PRICE_CLOSE);
-   atrHandle   = iATR(_Symbol, PERIOD_H1, InpATRPeriod);
+   // Seed H1 indicator state once from history
+   if(!h1State.Initialize(_Symbol, PERIOD_H1, InpTrendPeriod, InpRSIPeriod, InpATRPeriod,
+                          InpMACDFastPeriod, InpMACDSlowPeriod, InpMACDSignalPeriod,
+                          InpIndicatorSeedBars)) {
+      Print("Error seeding indicator state");
+      return(INIT_FAILED);
+   }
+   
+   // Create D1 exit handles once instead of on every tick
+   trendHandleHigher = handles.MA(_Symbol, PERIOD_D1, InpTrendPeriod, 0, MODE_EMA, PRICE_CLOSE);
+   rsiHandleHigher   = handles.RSI(_Symbol, PERIOD_D1, InpRSIPeriod, PRICE_CLOSE);
+   trendExitHandle   = handles.MA(_Symbol, PERIOD_D1, InpTrendExitPeriod, 0, MODE_EMA, PRICE_CLOSE);
    
-   if(trendHandle == INVALID_HANDLE || rsiHandle == INVALID_HANDLE || macdHandle == INVALID_HANDLE || atrHandle == INVALID_HANDLE) {
+   if(trendHandleHigher == INVALID_HANDLE || rsiHandleHigher == INVALID_HANDLE || trendExitHandle == INVALID_HANDLE) {
       Print("Error creating indicator handles");
       return(INIT_FAILED);
    }
    
+   // Exit buffers are reused by every tick instead of allocated per call
+   ArrayResize(trendValueHigher, 0, 8);
+   ArrayResize(rsiValueHigher, 0, 8);
+   
+   // Buffer log records and write them once per second
+   logger.Initialize("", InpLogLevel);
+   logger.SetRateLimit(InpLogRatePerMinute, 60);
+   EventSetTimer(1);
+   
+   BuildPipelines();
+   profiler.Enable(InpProfileDecisions);
+   decisionSection = profiler.Register("Decision");
+   
    return(INIT_SUCCEEDED);
 }
 
@@ -58,10 +223,82 @@ int OnInit()
 void OnDeinit(const int reason)
 {
    // Release indicator handles
-   IndicatorRelease(trendHandle);
-   IndicatorRelease(rsiHandle);  
-   IndicatorRelease(macdHandle);
-   IndicatorRelease(atrHandle);
+   handles.ReleaseAll();
+   
+   EventKillTimer();
+   if(InpProfileDecisions)
+      logger.Info("Profile", profiler.GetReport());
+   logger.Flush();
+   
+   delete longEntry;
+   delete shortEntry;
+   delete longExit;
+   delete shortExit;
+   longEntry = shortEntry = longExit = shortExit = NULL;
+}
+
+//+------------------------------------------------------------------+
+//| Compose entry/exit chains from the enabled features              |
+//+------------------------------------------------------------------+
+void BuildPipelines()
+{
+   longEntry  = new CGrandeRulePipeline<CTrendContext>(RULES_ALL, "LongEntry");
+   shortEntry = new CGrandeRulePipeline<CTrendContext>(RULES_ALL, "ShortEntry");
+   longExit   = new CGrandeRulePipeline<CTrendContext>(RULES_ANY, "LongExit");
+   shortExit  = new CGrandeRulePipeline<CTrendContext>(RULES_ANY, "ShortExit");
+   
+   if(InpUseTrendFilter) {
+      longEntry.Add(new CTrendSlopeRule(true));
+      shortEntry.Add(new CTrendSlopeRule(false));
+   }
+   longEntry.Add(new CRSICrossRule(InpRSILowerLevel, true));
+   shortEntry.Add(new CRSICrossRule(InpRSIUpperLevel, false));
+   
+   if(InpUseRSIExit) {
+      longExit.Add(new CD1RSIExitRule(InpRSIExitLevel, true));
+      shortExit.Add(new CD1RSIExitRule(100 - InpRSIExitLevel, false));
+   }
+   if(InpUseTrendExit) {
+      longExit.Add(new CD1TrendExitRule(true));
+      shortExit.Add(new CD1TrendExitRule(false));
+   }
+   useTrailing = InpUseATRTrailing && InpATRMultiplier > 0;
+   
+   longEntry.Compile();
+   shortEntry.Compile();
+   longExit.Compile();
+   shortExit.Compile();
+   
+   logger.Info("Rules", longEntry.Describe() + " | " + shortEntry.Describe());
+   logger.Info("Rules", longExit.Describe() + " | " + shortExit.Describe() + (useTrailing ? " | ATR trailing" : ""));
+}
+
+//+------------------------------------------------------------------+
+//| Close on an exit trigger once the minimum hold has passed        |
+//+------------------------------------------------------------------+
+void ApplyExit(CGrandeRulePipeline<CTrendContext> *exitChain, string side)
+{
+   if(!exitChain.Evaluate(ctx))
+      return;
+   
+   string rule = exitChain.GetLastDecisiveName();
+   datetime posOpenTime = (datetime)PositionGetInteger(POSITION_TIME);
+   int posDuration = (int)((TimeCurrent() - posOpenTime) / 60);
+   if(posDuration >= InpMinHoldDuration) {
+      trade.PositionClose(_Symbol);
+      logger.Info("Trade", side + " position closed by " + rule, side + "Close");
+   }
+   else {
+      logger.Info("Trade", side + " position " + rule + " triggered but minimum holding period not met", side + rule + "Hold");
+   }
+}
+
+//+------------------------------------------------------------------+
+//| Timer function                                                   |
+//+------------------------------------------------------------------+
+void OnTimer()
+{
+   logger.Flush();
 }
 
 //+------------------------------------------------------------------+
@@ -73,34 +310,34 @@ void OnTick()
    double bid = SymbolInfoDouble(_Symbol, SYMBOL_BID);
    double ask = SymbolInfoDouble(_Symbol, SYMBOL_ASK);
    
-   // Get indicator values
-   double trendValue[];
-   double rsiValue[];
-   double macdMain[];
-   double macdSignal[];
+   // Commit closed H1 bars and patch the forming one
+   if(!h1State.Update() || !h1State.IsReady())
+      return;
    
-   ArraySetAsSeries(trendValue, true);
-   ArraySetAsSeries(rsiValue, true);
-   ArraySetAsSeries(macdMain, true);
-   ArraySetAsSeries(macdSignal, true);
+   // Get indicator values (index 0 = forming bar, as with series buffers)
+   double trendValue[3];
+   double rsiValue[3];
+   double macdMain[3];
+   double macdSignal[3];
    
-   CopyBuffer(trendHandle, 0, 0, 3, trendValue);
-   CopyBuffer(rsiHandle, 0, 0, 3, rsiValue);
-   CopyBuffer(macdHandle, 0, 0, 3, macdMain);
-   CopyBuffer(macdHandle, 1, 0, 3, macdSignal);
+   for(int i = 0; i < 3; i++) {
+      trendValue[i] = h1State.ema.Value(i);
+      rsiValue[i]   = h1State.rsi.Value(i);
+      macdMain[i]   = h1State.macd.Main(i);
+      macdSignal[i] = h1State.macd.Signal(i);
+   }
    
    // Get current ATR value
-   double atrValue[];
-   ArraySetAsSeries(atrValue, true);
-   CopyBuffer(atrHandle, 0, 0, 1, atrValue);
-   double currentATR = atrValue[0];
-   
-   // Log indicator values
-   Print("Trend EMA Values: ", trendValue[0], ", ", trendValue[1], ", ", trendValue[2]);
-   Print("RSI Values: ", rsiValue[0], ", ", rsiValue[1], ", ", rsiValue[2]);
-   Print("MACD Main Values: ", macdMain[0], ", ", macdMain[1], ", ", macdMain[2]);
-   Print("MACD Signal Values: ", macdSignal[0], ", ", macdSignal[1], ", ", macdSignal[2]);
-   Print("Current ATR Value: ", currentATR);
+   double currentATR = h1State.atr.Value(0);
+   
+   // Log indicator values (formatted only when DEBUG is enabled)
+   if(logger.IsEnabled(GRANDE_LOG_DEBUG)) {
+      logger.Debug("H1", StringFormat("EMA %.5f, %.5f, %.5f | RSI %.2f, %.2f, %.2f | MACD %.6f/%.6f, %.6f/%.6f | ATR %.5f",
+                         trendValue[0], trendValue[1], trendValue[2],
+                         rsiValue[0], rsiValue[1], rsiValue[2],
+                         macdMain[0], macdSignal[0], macdMain[1], macdSignal[1],
+                         currentATR));
+   }
    
    // Check for new bar
    static datetime prevBarTime = 0;
@@ -111,122 +348,62 @@ void OnTick()
    }
    prevBarTime = currentBarTime;
    
+   CGrandeProfileScope decisionScope(GetPointer(profiler), decisionSection);
+   
+   ctx.Reset();
+   ctx.bid = bid;
+   ctx.ask = ask;
+   ctx.atr = currentATR;
+   ArrayCopy(ctx.trend, trendValue);
+   ArrayCopy(ctx.rsi, rsiValue);
+   
+   double point = SymbolInfoDouble(_Symbol, SYMBOL_POINT);
+   
    // Check for long entry
-   if(trendValue[0] > trendValue[1] &&                                    // Uptrend
-      rsiValue[0] > InpRSILowerLevel && rsiValue[1] <= InpRSILowerLevel)   // RSI crossing above lower level
+   if(longEntry.Evaluate(ctx))
    {
-      double sl = bid - InpStopLoss * SymbolInfoDouble(_Symbol, SYMBOL_POINT);
-      double tp = ask + InpTakeProfit * SymbolInfoDouble(_Symbol, SYMBOL_POINT);
+      double sl = bid - InpStopLoss * point;
+      double tp = ask + InpTakeProfit * point;
       
       trade.Buy(InpLotSize, _Symbol, ask, sl, tp, "Trend EA Long");
-      Print("Long position opened");
+      logger.Info("Trade", "Long position opened", "LongOpen");
    }
    
    // Check for short entry 
-   if(trendValue[0] < trendValue[1] &&                                    // Downtrend 
-      rsiValue[0] < InpRSIUpperLevel && rsiValue[1] >= InpRSIUpperLevel)   // RSI crossing below upper level
+   if(shortEntry.Evaluate(ctx))
    {
-      double sl = ask + InpStopLoss * SymbolInfoDouble(_Symbol, SYMBOL_POINT);
-      double tp = bid - InpTakeProfit * SymbolInfoDouble(_Symbol, SYMBOL_POINT);
+      double sl = ask + InpStopLoss * point;
+      double tp = bid - InpTakeProfit * point;
       
       trade.Sell(InpLotSize, _Symbol, bid, sl, tp, "Trend EA Short");
-      Print("Short position opened");
+      logger.Info("Trade", "Short position opened", "ShortOpen");
    }
    
    // Check for exit based on higher timeframe reversal
-   if(PositionSelect(_Symbol)) {
-      
-      ENUM_POSITION_TYPE posType = (ENUM_POSITION_TYPE)PositionGetInteger(POSITION_TYPE);
-      
-      double trendValueHigher[];
-      double rsiValueHigher[];
-      
-      ArraySetAsSeries(trendValueHigher, true);
-      ArraySetAsSeries(rsiValueHigher, true);
-      
-      int trendHandleHigher = iMA(_Symbol, PERIOD_D1, InpTrendPeriod, 0, MODE_EMA, PRICE_CLOSE); 
-      int rsiHandleHigher   = iRSI(_Symbol, PERIOD_D1, InpRSIPeriod, PRICE_CLOSE);
-      
-      CopyBuffer(trendHandleHigher, 0, 0, 3, trendValueHigher);
-      CopyBuffer(rsiHandleHigher, 0, 0, 3, rsiValueHigher);
-      
-      Print("D1 Trend EMA Values: ", trendValueHigher[0], ", ", trendValueHigher[1], ", ", trendValueHigher[2]);
-      Print("D1 RSI Values: ", rsiValueHigher[0], ", ", rsiValueHigher[1], ", ", rsiValueHigher[2]);
-      
-      // Get position open time
-      datetime posOpenTime = (datetime)PositionGetInteger(POSITION_TIME);
-      
-      // Calculate position duration in minutes
-      int posDuration = (int)((TimeCurrent() - posOpenTime) / 60);
-      
-      if(posType == POSITION_TYPE_BUY) {
-         
-         // Adjust RSI exit condition
-         if(rsiValueHigher[0] > InpRSIExitLevel && rsiValueHigher[1] <= InpRSIExitLevel) {
-            if(posDuration >= InpMinHoldDuration) {
-               trade.PositionClose(_Symbol);
-               Print("Long position closed due to RSI crossing above exit level");
-            }
-            else {
-               Print("Long position RSI exit triggered but minimum holding period not met");
-            }
-         }
-         
-         // Modify Trend EMA exit condition
-         double trendExitValue = iMA(_Symbol, PERIOD_D1, InpTrendExitPeriod, 0, MODE_EMA, PRICE_CLOSE);
-         if(trendValueHigher[1] > trendExitValue && trendValueHigher[0] < trendExitValue) {
-            if(posDuration >= InpMinHoldDuration) {
-               trade.PositionClose(_Symbol);
-               Print("Long position closed due to price crossing below Trend EMA");
-            }
-            else {
-               Print("Long position trend exit triggered but minimum holding period not met");
-            }
-         }
-         
-         // Introduce ATR-based trailing stop loss
-         double currentStop = PositionGetDouble(POSITION_SL);
-         double newStop = bid - InpATRMultiplier * currentATR;
-         if(newStop > currentStop) {
-            trade.PositionModify(_Symbol, newStop, PositionGetDouble(POSITION_TP));
-            Print("Long position ATR-based trailing stop updated to: ", newStop);
-         }
+   if(!PositionSelect(_Symbol))
+      return;
+   
+   ENUM_POSITION_TYPE posType = (ENUM_POSITION_TYPE)PositionGetInteger(POSITION_TYPE);
+   bool isLong = (posType == POSITION_TYPE_BUY);
+   ApplyExit(isLong ? longExit : shortExit, isLong ? "Long" : "Short");
+   
+   // ATR-based trailing stop loss
+   if(!useTrailing || !PositionSelect(_Symbol))
+      return;
+   
+   double currentStop = PositionGetDouble(POSITION_SL);
+   if(isLong) {
+      double newStop = bid - InpATRMultiplier * currentATR;
+      if(newStop > currentStop) {
+         trade.PositionModify(_Symbol, newStop, PositionGetDouble(POSITION_TP));
+         logger.Info("Trade", "Long position ATR-based trailing stop updated to: " + DoubleToString(newStop, _Digits), "LongTrailing");
       }
-      else if(posType == POSITION_TYPE_SELL) {
-         
-         // Adjust RSI exit condition
-         if(rsiValueHigher[0] < (100 - InpRSIExitLevel) && rsiValueHigher[1] >= (100 - InpRSIExitLevel)) {
-            if(posDuration >= InpMinHoldDuration) {
-               trade.PositionClose(_Symbol);
-               Print("Short position closed due to RSI crossing below exit level");
-            }
-            else {
-               Print("Short position RSI exit triggered but minimum holding period not met");
-            }
-         }
-         
-         // Modify Trend EMA exit condition 
-         double trendExitValue = iMA(_Symbol, PERIOD_D1, InpTrendExitPeriod, 0, MODE_EMA, PRICE_CLOSE);
-         if(trendValueHigher[1] < trendExitValue && trendValueHigher[0] > trendExitValue) {
-            if(posDuration >= InpMinHoldDuration) {
-               trade.PositionClose(_Symbol);
-               Print("Short position closed due to price crossing above Trend EMA");
-            }
-            else {
-               Print("Short position trend exit triggered but minimum holding period not met");  
-            }
-         }
-         
-         // Introduce ATR-based trailing stop loss
-         double currentStop = PositionGetDouble(POSITION_SL);
-         double newStop = ask + InpATRMultiplier * currentATR;
-         if(newStop < currentStop) {
-            trade.PositionModify(_Symbol, newStop, PositionGetDouble(POSITION_TP));
-            Print("Short position ATR-based trailing stop updated to: ", newStop);
-         }
+   }
+   else {
+      double newStop = ask + InpATRMultiplier * currentATR;
+      if(newStop < currentStop) {
+         trade.PositionModify(_Symbol, newStop, PositionGetDouble(POSITION_TP));
+         logger.Info("Trade", "Short position ATR-based trailing stop updated to: " + DoubleToString(newStop, _Digits), "ShortTrailing");
       }
-      
-      IndicatorRelease(trendHandleHigher);
-      IndicatorRelease(rsiHandleHigher);
    }
 }
\ No newline at end of file